@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "batch.h"
+#include "jpeg.h"
+#include "zip_index.h"
+#include "zip_scan.h"
+
+typedef struct {
+    int error;
+    int jpeg;
+    int zip;
+    off_t jpeg_end;
+    off_t zip_offset;
+    uint64_t entries;
+    const char* method;
+} file_report;
+
+typedef struct {
+    const batch_list* list;
+    atomic_size_t next;
+    atomic_size_t failures;
+} batch_pool;
+
+static int push_path(batch_list* list, const char* path){
+    if (list->count == list->capacity){
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        char** grown = realloc(list->paths, capacity * sizeof(char*));
+        if (grown == NULL){
+            return -1;
+        }
+        list->paths = grown;
+        list->capacity = capacity;
+    }
+    list->paths[list->count] = strdup(path);
+    return list->paths[list->count++] ? 0 : -1;
+}
+
+static int skip_dots(const struct dirent* entry){
+    return strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0;
+}
+
+static int add_directory(batch_list* list, const char* path){
+    struct dirent** names = NULL;
+    int count = scandir(path, &names, skip_dots, alphasort);
+    if (count < 0){
+        return push_path(list, path);
+    }
+    int status = 0;
+    size_t path_len = strlen(path);
+    int needs_slash = path_len > 0 && path[path_len - 1] != '/';
+    for (int i = 0; i < count; i++){
+        size_t child_len = path_len + needs_slash + strlen(names[i]->d_name) + 1;
+        char* child = status == 0 ? malloc(child_len) : NULL;
+        if (child != NULL){
+            snprintf(child, child_len, "%s%s%s", path, needs_slash ? "/" : "", names[i]->d_name);
+            struct stat st;
+            if (lstat(child, &st) != 0){
+                status = push_path(list, child);
+            } else if (S_ISDIR(st.st_mode)){
+                status = add_directory(list, child);
+            } else if (S_ISREG(st.st_mode) || (S_ISLNK(st.st_mode) && stat(child, &st) == 0 && S_ISREG(st.st_mode))){
+                status = push_path(list, child);
+            }
+        } else {
+            status = -1;
+        }
+        free(child);
+        free(names[i]);
+    }
+    free(names);
+    return status;
+}
+
+int batch_add_path(batch_list* list, const char* path){
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)){
+        return add_directory(list, path);
+    }
+    return push_path(list, path);
+}
+
+void batch_free(batch_list* list){
+    for (size_t i = 0; i < list->count; i++){
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    memset(list, 0, sizeof(*list));
+}
+
+static void remember_first(void* ctx, off_t offset, const char* name, size_t name_len){
+    (void)name;
+    (void)name_len;
+    off_t* first = (off_t*)ctx;
+    if (*first < 0){
+        *first = offset;
+    }
+}
+
+static void classify(const char* path, file_report* report){
+    memset(report, 0, sizeof(*report));
+    report->jpeg_end = -1;
+    report->zip_offset = -1;
+    report->method = "none";
+    FILE* file = fopen(path, "rb");
+    if (file == NULL){
+        report->error = errno;
+        return;
+    }
+    off_t file_size = -1;
+    if (fseeko(file, 0, SEEK_END) == 0){
+        file_size = ftello(file);
+    }
+    if (file_size < 0){
+        report->error = errno ? errno : EIO;
+        fclose(file);
+        return;
+    }
+
+    jpeg_info jpeg;
+    report->jpeg = jpeg_inspect(file, file_size, &jpeg) == 0;
+    if (report->jpeg && jpeg_find_end(file, file_size, &jpeg) == 0){
+        report->jpeg_end = jpeg.end;
+    }
+    zip_index index;
+    if (find_central_directory(file, file_size, &index) == 0){
+        report->zip = index.entries > 0;
+        report->entries = index.entries;
+        if (find_first_local_header(file, &index, &report->zip_offset) != 0){
+            report->zip_offset = -1;
+        }
+        report->method = "central_directory";
+    } else if (report->jpeg_end >= 0){
+        report->method = "markers";
+        if (jpeg.end < file_size){
+            off_t first = -1;
+            int found = scan_local_headers(file, jpeg.end, file_size, remember_first, &first);
+            if (found > 0){
+                report->zip = 1;
+                report->entries = (uint64_t)found;
+                report->zip_offset = first;
+                report->method = "local_scan";
+            }
+        }
+    }
+    fclose(file);
+}
+
+static size_t utf8_length(const unsigned char* p){
+    size_t length;
+    uint32_t min;
+    if (*p >= 0xC2 && *p <= 0xDF){
+        length = 2;
+        min = 0x80;
+    } else if (*p >= 0xE0 && *p <= 0xEF){
+        length = 3;
+        min = 0x800;
+    } else if (*p >= 0xF0 && *p <= 0xF4){
+        length = 4;
+        min = 0x10000;
+    } else {
+        return 0;
+    }
+    uint32_t code = *p & (0x7F >> length);
+    for (size_t i = 1; i < length; i++){
+        if ((p[i] & 0xC0) != 0x80){
+            return 0;
+        }
+        code = code << 6 | (p[i] & 0x3F);
+    }
+    if (code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)){
+        return 0;
+    }
+    return length;
+}
+
+static void print_json_string(FILE* out, const char* text){
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++){
+        size_t length;
+        if (*p == '"' || *p == '\\'){
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if (*p < 0x20){
+            fprintf(out, "\\u%04x", *p);
+        } else if (*p < 0x80){
+            fputc(*p, out);
+        } else if ((length = utf8_length(p)) > 0){
+            fwrite(p, 1, length, out);
+            p += length - 1;
+        } else {
+            fprintf(out, "\\u%04x", *p);
+        }
+    }
+    fputc('"', out);
+}
+
+static void print_offset(FILE* out, const char* key, off_t value){
+    if (value < 0){
+        fprintf(out, ",\"%s\":null", key);
+    } else {
+        fprintf(out, ",\"%s\":%lld", key, (long long)value);
+    }
+}
+
+static void print_report(const char* path, const file_report* report){
+    flockfile(stdout);
+    fputs("{\"path\":", stdout);
+    print_json_string(stdout, path);
+    if (report->error){
+        fputs(",\"error\":", stdout);
+        print_json_string(stdout, strerror(report->error));
+    } else {
+        printf(",\"jpeg\":%s,\"zip\":%s,\"polyglot\":%s,\"entries\":%llu",
+            report->jpeg ? "true" : "false", report->zip ? "true" : "false",
+            report->jpeg && report->zip ? "true" : "false", (unsigned long long)report->entries);
+        print_offset(stdout, "jpeg_end", report->jpeg_end);
+        print_offset(stdout, "zip_offset", report->zip_offset);
+        printf(",\"method\":\"%s\"", report->method);
+    }
+    fputs("}\n", stdout);
+    funlockfile(stdout);
+}
+
+static void* batch_worker(void* arg){
+    batch_pool* pool = (batch_pool*)arg;
+    for (;;){
+        size_t index = atomic_fetch_add(&pool->next, 1);
+        if (index >= pool->list->count){
+            break;
+        }
+        file_report report;
+        classify(pool->list->paths[index], &report);
+        if (report.error){
+            atomic_fetch_add(&pool->failures, 1);
+        }
+        print_report(pool->list->paths[index], &report);
+    }
+    return NULL;
+}
+
+int batch_run(const batch_list* list, size_t threads){
+    batch_pool pool;
+    pool.list = list;
+    atomic_init(&pool.next, 0);
+    atomic_init(&pool.failures, 0);
+    if (threads > list->count){
+        threads = list->count > 0 ? list->count : 1;
+    }
+    pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+    size_t started = 0;
+    for (size_t i = 0; workers && i < threads; i++){
+        if (pthread_create(&workers[i], NULL, batch_worker, &pool) != 0){
+            break;
+        }
+        started++;
+    }
+    if (started == 0){
+        batch_worker(&pool);
+    }
+    for (size_t i = 0; i < started; i++){
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    return atomic_load(&pool.failures) > 0 ? -1 : 0;
+}
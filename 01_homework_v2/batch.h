@@ -0,0 +1,16 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+typedef struct {
+    char** paths;
+    size_t count;
+    size_t capacity;
+} batch_list;
+
+int batch_add_path(batch_list* list, const char* path);
+int batch_run(const batch_list* list, size_t threads);
+void batch_free(batch_list* list);
+
+#endif
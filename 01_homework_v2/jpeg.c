@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include "jpeg.h"
+
+#define JPEG_CHUNK_SIZE (64 * 1024)
+
+#define MARKER_TEM 0x01
+#define MARKER_RST0 0xD0
+#define MARKER_RST7 0xD7
+#define MARKER_SOI 0xD8
+#define MARKER_EOI 0xD9
+#define MARKER_SOS 0xDA
+
+static int read_at(FILE* file, off_t offset, void* buffer, size_t size){
+    if (fseeko(file, offset, SEEK_SET) != 0){
+        return -1;
+    }
+    return fread(buffer, 1, size, file) == size ? 0 : -1;
+}
+
+static int standalone_marker(unsigned char marker){
+    return marker == MARKER_TEM || marker == MARKER_SOI || (marker >= MARKER_RST0 && marker <= MARKER_RST7);
+}
+
+static off_t walk_segments(FILE* file, off_t file_size, off_t pos, jpeg_info* info){
+    for (;;){
+        unsigned char bytes[4];
+        if (pos + 2 > file_size || read_at(file, pos, bytes, 2) != 0 || bytes[0] != 0xFF){
+            return -1;
+        }
+        unsigned char marker = bytes[1];
+        if (marker == 0xFF){
+            pos++;
+            continue;
+        }
+        if (marker == MARKER_EOI){
+            info->end = pos + 2;
+            return 0;
+        }
+        if (standalone_marker(marker)){
+            pos += 2;
+            continue;
+        }
+        if (pos + 4 > file_size || read_at(file, pos + 2, bytes + 2, 2) != 0){
+            return -1;
+        }
+        unsigned length = ((unsigned)bytes[2] << 8) | bytes[3];
+        if (length < 2){
+            return -1;
+        }
+        pos += 2 + length;
+        if (marker == MARKER_SOS){
+            return pos;
+        }
+    }
+}
+
+int jpeg_inspect(FILE* file, off_t file_size, jpeg_info* info){
+    memset(info, 0, sizeof(*info));
+    info->end = -1;
+    unsigned char bytes[2];
+    if (file_size < 4 || read_at(file, 0, bytes, 2) != 0 || bytes[0] != 0xFF || bytes[1] != MARKER_SOI){
+        return -1;
+    }
+    off_t scan = walk_segments(file, file_size, 2, info);
+    if (scan < 0 || scan > file_size){
+        return -1;
+    }
+    info->valid = 1;
+    info->scan_offset = scan;
+    return 0;
+}
+
+int jpeg_find_end(FILE* file, off_t file_size, jpeg_info* info){
+    if (!info->valid){
+        return -1;
+    }
+    if (info->end >= 0){
+        return 0;
+    }
+    unsigned char* buffer = malloc(JPEG_CHUNK_SIZE);
+    if (buffer == NULL){
+        return -1;
+    }
+    off_t pos = info->scan_offset;
+    int status = -1;
+    while (pos < file_size){
+        size_t wanted = file_size - pos < JPEG_CHUNK_SIZE ? (size_t)(file_size - pos) : JPEG_CHUNK_SIZE;
+        if (read_at(file, pos, buffer, wanted) != 0){
+            break;
+        }
+        size_t i = 0;
+        off_t marker_pos = -1;
+        while (i + 1 < wanted){
+            unsigned char* hit = memchr(buffer + i, 0xFF, wanted - i - 1);
+            if (hit == NULL){
+                i = wanted - 1;
+                break;
+            }
+            i = (size_t)(hit - buffer);
+            unsigned char next = buffer[i + 1];
+            if (next == 0x00 || next == 0xFF || (next >= MARKER_RST0 && next <= MARKER_RST7)){
+                i++;
+                continue;
+            }
+            marker_pos = pos + (off_t)i;
+            break;
+        }
+        if (marker_pos < 0){
+            if (wanted < 2){
+                break;
+            }
+            pos += (off_t)i;
+            continue;
+        }
+        off_t scan = walk_segments(file, file_size, marker_pos, info);
+        if (scan == 0){
+            status = 0;
+            break;
+        }
+        if (scan < 0){
+            break;
+        }
+        pos = scan;
+    }
+    free(buffer);
+    return status;
+}
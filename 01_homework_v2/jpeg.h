@@ -0,0 +1,16 @@
+#ifndef JPEG_H
+#define JPEG_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+typedef struct {
+    int valid;
+    off_t scan_offset;
+    off_t end;
+} jpeg_info;
+
+int jpeg_inspect(FILE* file, off_t file_size, jpeg_info* info);
+int jpeg_find_end(FILE* file, off_t file_size, jpeg_info* info);
+
+#endif
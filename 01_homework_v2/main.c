@@ -1,73 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "zip_index.h"
+#include "zip_scan.h"
+#include "batch.h"
 
-typedef unsigned char uchar;
-
-#pragma pack(push, 1)
-typedef struct {
-    uint32_t signature;
-    uint16_t version;
-    uint16_t flags;
-    uint16_t compression;
-    uint16_t mod_time;
-    uint16_t mod_date;
-    uint32_t crc32;
-    uint32_t compressed_size;
-    uint32_t uncompressed_size;
-    uint16_t filename_length;
-    uint16_t extra_field_length;
-} ZipLocalFileHeader;
-#pragma pack(pop)
+static void print_entry(void* ctx, off_t offset, const char* name, size_t name_len)
+{
+    (void)ctx;
+    (void)offset;
+    printf("File name: %.*s\n", (int)name_len, name);
+}
 
-int main(int argc, char** argv)
+static int parse_threads(const char* text, size_t* out)
 {
-    if(argc != 2) {
-        printf("USAGE: %s <file>\n", argv[0]);
-        return EXIT_FAILURE;
+    char* endptr = NULL;
+    long value = strtol(text, &endptr, 10);
+    if (endptr == text || *endptr != '\0' || value <= 0) {
+        return -1;
     }
-    FILE* file = fopen(argv[1], "rb");
+    *out = (size_t)value;
+    return 0;
+}
+
+static int list_file(const char* path, int force_scan)
+{
+    FILE* file = fopen(path, "rb");
     if(!file) {
-        printf("Failed to open %s for reading!\n", argv[1]);
+        printf("Failed to open %s for reading!\n", path);
         return EXIT_FAILURE;
     }
-    fseek(file, 0, SEEK_END);
-    uint32_t file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    uchar *buffer = (uchar *)malloc(file_size);
-    fread(buffer, 1, file_size, file);
-    uchar signature[] = {0x50, 0x4B, 0x03, 0x04};
-    int seg_len = 4;
+    fseeko(file, 0, SEEK_END);
+    off_t file_size = ftello(file);
+
     int found_any = 0;
-    for(uint32_t i = 0; i <= file_size - seg_len; ) {
-        if (memcmp(&buffer[i], signature, seg_len) == 0) {
-            found_any = 1;
-            if (i + sizeof(ZipLocalFileHeader) > file_size) {
-                break;
-            }
-            ZipLocalFileHeader header;
-            memcpy(&header, &buffer[i], sizeof(ZipLocalFileHeader));
-            if (header.signature != 0x04034b50){
-                printf("Invalid signature\n");
-                continue;
-            }
-            int offset = i + sizeof(ZipLocalFileHeader);
-            char *filename = malloc(header.filename_length + 1);
-            memcpy(filename, &buffer[offset], header.filename_length);
-            filename[header.filename_length] = '\0';
-            printf("File name: %s\n", filename);
-            free(filename);
-            i += header.filename_length + header.extra_field_length + header.compressed_size;
-        }
-        else {
-            i++;
+    zip_index index;
+    if (!force_scan && find_central_directory(file, file_size, &index) == 0 &&
+        list_central_directory(file, &index) == 0) {
+        found_any = index.entries > 0;
+    } else {
+        found_any = scan_local_headers(file, 0, file_size, print_entry, NULL);
+        if (found_any < 0) {
+            printf("Failed to read file!\n");
+            fclose(file);
+            return EXIT_FAILURE;
         }
     }
     if (!found_any){
         printf("It is not zipjpeg!\n");
     }
-    free(buffer);
-    fclose(file); 
+    fclose(file);
     return EXIT_SUCCESS;
 }
+
+static int classify_files(char** paths, int count, size_t threads)
+{
+    batch_list list = {0};
+    for (int i = 0; i < count; i++) {
+        if (batch_add_path(&list, paths[i]) != 0) {
+            fprintf(stderr, "Failed to collect %s\n", paths[i]);
+            batch_free(&list);
+            return EXIT_FAILURE;
+        }
+    }
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    int status = batch_run(&list, threads);
+    batch_free(&list);
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv)
+{
+    char** paths = malloc(sizeof(char*) * argc);
+    int path_count = 0;
+    int force_scan = 0;
+    int json = 0;
+    size_t threads = 0;
+    int usage_error = paths == NULL;
+    for (int i = 1; i < argc && !usage_error; i++) {
+        if (strcmp(argv[i], "--scan") == 0) {
+            force_scan = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            usage_error |= parse_threads(argv[++i], &threads) != 0;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            usage_error = 1;
+        } else {
+            paths[path_count++] = argv[i];
+        }
+    }
+    struct stat st;
+    if (path_count > 1 || (path_count == 1 && stat(paths[0], &st) == 0 && S_ISDIR(st.st_mode))) {
+        json = 1;
+    }
+    if(path_count == 0 || usage_error || (json && force_scan)) {
+        printf("USAGE: %s [--scan] <file>\n", argv[0]);
+        printf("       %s [--json] [--threads N] <path>...\n", argv[0]);
+        free(paths);
+        return EXIT_FAILURE;
+    }
+    int result = json ? classify_files(paths, path_count, threads) : list_file(paths[0], force_scan);
+    free(paths);
+    return result;
+}
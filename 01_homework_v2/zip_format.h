@@ -0,0 +1,79 @@
+#ifndef ZIP_FORMAT_H
+#define ZIP_FORMAT_H
+
+#include <stdint.h>
+
+#define ZIP_LOCAL_SIGNATURE 0x04034b50
+#define ZIP_CENTRAL_SIGNATURE 0x02014b50
+#define ZIP_EOCD_SIGNATURE 0x06054b50
+#define ZIP64_EOCD_SIGNATURE 0x06064b50
+#define ZIP64_LOCATOR_SIGNATURE 0x07064b50
+
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t signature;
+    uint16_t version;
+    uint16_t flags;
+    uint16_t compression;
+    uint16_t mod_time;
+    uint16_t mod_date;
+    uint32_t crc32;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint16_t filename_length;
+    uint16_t extra_field_length;
+} ZipLocalFileHeader;
+
+typedef struct {
+    uint32_t signature;
+    uint16_t version_made_by;
+    uint16_t version_needed;
+    uint16_t flags;
+    uint16_t compression;
+    uint16_t mod_time;
+    uint16_t mod_date;
+    uint32_t crc32;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint16_t filename_length;
+    uint16_t extra_field_length;
+    uint16_t comment_length;
+    uint16_t disk_number_start;
+    uint16_t internal_attributes;
+    uint32_t external_attributes;
+    uint32_t local_header_offset;
+} ZipCentralDirectoryHeader;
+
+typedef struct {
+    uint32_t signature;
+    uint16_t disk_number;
+    uint16_t central_directory_disk;
+    uint16_t disk_entries;
+    uint16_t total_entries;
+    uint32_t central_directory_size;
+    uint32_t central_directory_offset;
+    uint16_t comment_length;
+} ZipEndOfCentralDirectory;
+
+typedef struct {
+    uint32_t signature;
+    uint32_t zip64_eocd_disk;
+    uint64_t zip64_eocd_offset;
+    uint32_t total_disks;
+} Zip64EndOfCentralDirectoryLocator;
+
+typedef struct {
+    uint32_t signature;
+    uint64_t record_size;
+    uint16_t version_made_by;
+    uint16_t version_needed;
+    uint32_t disk_number;
+    uint32_t central_directory_disk;
+    uint64_t disk_entries;
+    uint64_t total_entries;
+    uint64_t central_directory_size;
+    uint64_t central_directory_offset;
+} Zip64EndOfCentralDirectory;
+#pragma pack(pop)
+
+#endif
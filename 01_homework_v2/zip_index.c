@@ -0,0 +1,214 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include "zip_index.h"
+#include "zip_format.h"
+
+#define ZIP_MAX_COMMENT 0xFFFF
+#define ZIP64_EXTRA_ID 0x0001
+
+static int read_at(FILE* file, off_t offset, void* buffer, size_t size){
+    if (fseeko(file, offset, SEEK_SET) != 0){
+        return -1;
+    }
+    return fread(buffer, 1, size, file) == size ? 0 : -1;
+}
+
+static int has_signature(FILE* file, off_t offset, uint32_t signature){
+    uint32_t value;
+    return offset >= 0 && read_at(file, offset, &value, sizeof(value)) == 0 && value == signature;
+}
+
+static int read_zip64_record(FILE* file, off_t locator_offset, Zip64EndOfCentralDirectory* record, off_t* record_offset){
+    Zip64EndOfCentralDirectoryLocator locator;
+    if (locator_offset < 0 || read_at(file, locator_offset, &locator, sizeof(locator)) != 0 ||
+        locator.signature != ZIP64_LOCATOR_SIGNATURE){
+        return -1;
+    }
+    off_t candidates[2] = {
+        (off_t)locator.zip64_eocd_offset,
+        locator_offset - (off_t)sizeof(Zip64EndOfCentralDirectory),
+    };
+    for (int i = 0; i < 2; i++){
+        off_t offset = candidates[i];
+        if (offset < 0 || offset >= locator_offset || read_at(file, offset, record, sizeof(*record)) != 0){
+            continue;
+        }
+        if (record->signature == ZIP64_EOCD_SIGNATURE && offset + 12 + (off_t)record->record_size == locator_offset){
+            *record_offset = offset;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int resolve_index(FILE* file, off_t eocd_offset, const ZipEndOfCentralDirectory* eocd, zip_index* index){
+    index->eocd_offset = eocd_offset;
+    index->entries = eocd->total_entries;
+    index->central_directory_size = eocd->central_directory_size;
+    uint64_t stated_offset = eocd->central_directory_offset;
+    off_t directory_end = eocd_offset;
+    index->zip64 = eocd->total_entries == 0xFFFF || eocd->central_directory_size == 0xFFFFFFFF ||
+                   eocd->central_directory_offset == 0xFFFFFFFF;
+    if (index->zip64){
+        Zip64EndOfCentralDirectory record;
+        off_t locator_offset = eocd_offset - (off_t)sizeof(Zip64EndOfCentralDirectoryLocator);
+        if (read_zip64_record(file, locator_offset, &record, &directory_end) != 0){
+            return -1;
+        }
+        index->entries = record.total_entries;
+        index->central_directory_size = record.central_directory_size;
+        stated_offset = record.central_directory_offset;
+    }
+    if (index->central_directory_size > (uint64_t)directory_end){
+        return -1;
+    }
+    index->central_directory_start = directory_end - (off_t)index->central_directory_size;
+    index->central_directory_offset = stated_offset;
+    if (index->entries == 0){
+        return index->central_directory_size == 0 ? 0 : -1;
+    }
+    return has_signature(file, index->central_directory_start, ZIP_CENTRAL_SIGNATURE) ? 0 : -1;
+}
+
+int find_central_directory(FILE* file, off_t file_size, zip_index* index){
+    if (file_size < (off_t)sizeof(ZipEndOfCentralDirectory)){
+        return -1;
+    }
+    size_t tail_size = sizeof(ZipEndOfCentralDirectory) + ZIP_MAX_COMMENT;
+    if ((off_t)tail_size > file_size){
+        tail_size = (size_t)file_size;
+    }
+    off_t tail_start = file_size - (off_t)tail_size;
+    unsigned char* tail = malloc(tail_size);
+    if (tail == NULL || read_at(file, tail_start, tail, tail_size) != 0){
+        free(tail);
+        return -1;
+    }
+    int status = -1;
+    for (size_t pos = tail_size - sizeof(ZipEndOfCentralDirectory) + 1; pos-- > 0 && status != 0;){
+        if (tail[pos] != 0x50 || tail[pos + 1] != 0x4B || tail[pos + 2] != 0x05 || tail[pos + 3] != 0x06){
+            continue;
+        }
+        ZipEndOfCentralDirectory eocd;
+        memcpy(&eocd, &tail[pos], sizeof(eocd));
+        if (pos + sizeof(eocd) + eocd.comment_length > tail_size || eocd.disk_number != eocd.central_directory_disk){
+            continue;
+        }
+        status = resolve_index(file, tail_start + (off_t)pos, &eocd, index);
+    }
+    free(tail);
+    return status;
+}
+
+int list_central_directory(FILE* file, const zip_index* index){
+    if (fseeko(file, index->central_directory_start, SEEK_SET) != 0){
+        return -1;
+    }
+    size_t names_size = 0;
+    size_t names_capacity = 256;
+    char* names = malloc(names_capacity);
+    uint64_t consumed = 0;
+    int status = names ? 0 : -1;
+    for (uint64_t i = 0; i < index->entries && status == 0; i++){
+        ZipCentralDirectoryHeader header;
+        if (fread(&header, 1, sizeof(header), file) != sizeof(header) || header.signature != ZIP_CENTRAL_SIGNATURE){
+            status = -1;
+            break;
+        }
+        uint64_t skip = (uint64_t)header.extra_field_length + header.comment_length;
+        consumed += sizeof(header) + header.filename_length + skip;
+        if (consumed > index->central_directory_size){
+            status = -1;
+            break;
+        }
+        size_t needed = names_size + header.filename_length + 1;
+        if (needed > names_capacity){
+            while (needed > names_capacity){
+                names_capacity *= 2;
+            }
+            char* grown = realloc(names, names_capacity);
+            if (grown == NULL){
+                status = -1;
+                break;
+            }
+            names = grown;
+        }
+        if (fread(names + names_size, 1, header.filename_length, file) != header.filename_length ||
+            fseeko(file, (off_t)skip, SEEK_CUR) != 0){
+            status = -1;
+            break;
+        }
+        names_size += header.filename_length;
+        names[names_size++] = '\0';
+    }
+    for (size_t offset = 0; status == 0 && offset < names_size; offset += strlen(names + offset) + 1){
+        printf("File name: %s\n", names + offset);
+    }
+    free(names);
+    return status;
+}
+
+static int zip64_local_offset(const unsigned char* extra, size_t length, const ZipCentralDirectoryHeader* header, uint64_t* offset){
+    size_t pos = 0;
+    while (pos + 4 <= length){
+        uint16_t id = (uint16_t)(extra[pos] | extra[pos + 1] << 8);
+        uint16_t size = (uint16_t)(extra[pos + 2] | extra[pos + 3] << 8);
+        pos += 4;
+        if (pos + size > length){
+            return -1;
+        }
+        if (id == ZIP64_EXTRA_ID){
+            size_t field = (header->uncompressed_size == 0xFFFFFFFF ? 8 : 0) +
+                           (header->compressed_size == 0xFFFFFFFF ? 8 : 0);
+            if (field + 8 > size){
+                return -1;
+            }
+            memcpy(offset, extra + pos + field, sizeof(*offset));
+            return 0;
+        }
+        pos += size;
+    }
+    return -1;
+}
+
+int find_first_local_header(FILE* file, const zip_index* index, off_t* offset){
+    if (index->entries == 0 || fseeko(file, index->central_directory_start, SEEK_SET) != 0){
+        return -1;
+    }
+    unsigned char* extra = malloc(0xFFFF);
+    off_t shift = index->central_directory_start - (off_t)index->central_directory_offset;
+    off_t first = -1;
+    uint64_t consumed = 0;
+    int status = extra ? 0 : -1;
+    for (uint64_t i = 0; i < index->entries && status == 0; i++){
+        ZipCentralDirectoryHeader header;
+        if (fread(&header, 1, sizeof(header), file) != sizeof(header) || header.signature != ZIP_CENTRAL_SIGNATURE){
+            status = -1;
+            break;
+        }
+        consumed += sizeof(header) + header.filename_length + header.extra_field_length + header.comment_length;
+        if (consumed > index->central_directory_size ||
+            fseeko(file, header.filename_length, SEEK_CUR) != 0 ||
+            fread(extra, 1, header.extra_field_length, file) != header.extra_field_length ||
+            fseeko(file, header.comment_length, SEEK_CUR) != 0){
+            status = -1;
+            break;
+        }
+        uint64_t local = header.local_header_offset;
+        if (local == 0xFFFFFFFF && zip64_local_offset(extra, header.extra_field_length, &header, &local) != 0){
+            status = -1;
+            break;
+        }
+        off_t candidate = shift + (off_t)local;
+        if (first < 0 || candidate < first){
+            first = candidate;
+        }
+    }
+    free(extra);
+    if (status != 0 || !has_signature(file, first, ZIP_LOCAL_SIGNATURE)){
+        return -1;
+    }
+    *offset = first;
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef ZIP_INDEX_H
+#define ZIP_INDEX_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct {
+    off_t eocd_offset;
+    off_t central_directory_start;
+    uint64_t entries;
+    uint64_t central_directory_size;
+    uint64_t central_directory_offset;
+    int zip64;
+} zip_index;
+
+int find_central_directory(FILE* file, off_t file_size, zip_index* index);
+int list_central_directory(FILE* file, const zip_index* index);
+int find_first_local_header(FILE* file, const zip_index* index, off_t* offset);
+
+#endif
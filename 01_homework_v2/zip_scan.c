@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include "zip_scan.h"
+#include "zip_format.h"
+
+#define SCAN_CHUNK_SIZE (1024 * 1024)
+#define SIGNATURE_LEN 4
+#define ZIP_SIZE_UNKNOWN 0xFFFFFFFF
+
+typedef struct {
+    FILE* file;
+    off_t file_size;
+    unsigned char* buffer;
+    off_t start;
+    size_t len;
+    size_t cursor;
+} scan_window;
+
+static int load_window(scan_window* window, off_t offset){
+    if (fseeko(window->file, offset, SEEK_SET) != 0){
+        return -1;
+    }
+    window->start = offset;
+    window->cursor = 0;
+    window->len = fread(window->buffer, 1, SCAN_CHUNK_SIZE, window->file);
+    return ferror(window->file) ? -1 : 0;
+}
+
+static int advance_window(scan_window* window){
+    size_t keep = window->len - window->cursor;
+    memmove(window->buffer, window->buffer + window->cursor, keep);
+    window->start += (off_t)window->cursor;
+    window->cursor = 0;
+    window->len = keep + fread(window->buffer + keep, 1, SCAN_CHUNK_SIZE - keep, window->file);
+    return ferror(window->file) ? -1 : 0;
+}
+
+static int find_signature(scan_window* window){
+    for (;;){
+        if (window->cursor + SIGNATURE_LEN > window->len){
+            off_t end = window->start + (off_t)window->len;
+            if (end >= window->file_size || advance_window(window) != 0 || window->len < SIGNATURE_LEN){
+                return 0;
+            }
+            continue;
+        }
+        size_t limit = window->len - SIGNATURE_LEN + 1;
+        unsigned char* hit = memchr(window->buffer + window->cursor, 0x50, limit - window->cursor);
+        if (hit == NULL){
+            window->cursor = limit;
+            continue;
+        }
+        window->cursor = (size_t)(hit - window->buffer);
+        if (hit[1] == 0x4B && hit[2] == 0x03 && hit[3] == 0x04){
+            return 1;
+        }
+        window->cursor++;
+    }
+}
+
+int scan_local_headers(FILE* file, off_t start, off_t file_size, zip_entry_callback on_entry, void* ctx){
+    scan_window window = { .file = file, .file_size = file_size };
+    window.buffer = malloc(SCAN_CHUNK_SIZE);
+    if (window.buffer == NULL || load_window(&window, start) != 0){
+        free(window.buffer);
+        return -1;
+    }
+    int found = 0;
+    while (find_signature(&window)){
+        found++;
+        off_t header_offset = window.start + (off_t)window.cursor;
+        if (header_offset + (off_t)sizeof(ZipLocalFileHeader) > file_size){
+            break;
+        }
+        if (window.cursor + sizeof(ZipLocalFileHeader) > window.len && load_window(&window, header_offset) != 0){
+            break;
+        }
+        ZipLocalFileHeader header;
+        memcpy(&header, window.buffer + window.cursor, sizeof(header));
+        size_t name_offset = window.cursor + sizeof(header);
+        if (name_offset + header.filename_length > window.len && window.cursor > 0){
+            if (load_window(&window, header_offset) != 0){
+                break;
+            }
+            name_offset = sizeof(header);
+        }
+        if (name_offset + header.filename_length > window.len){
+            break;
+        }
+        if (on_entry){
+            on_entry(ctx, header_offset, (const char*)window.buffer + name_offset, header.filename_length);
+        }
+
+        off_t next = header_offset + (off_t)sizeof(header) + header.filename_length + header.extra_field_length;
+        if (header.compressed_size != ZIP_SIZE_UNKNOWN){
+            next += header.compressed_size;
+        }
+        if (next <= window.start + (off_t)window.len){
+            window.cursor = (size_t)(next - window.start);
+        } else if (next >= file_size || load_window(&window, next) != 0){
+            break;
+        }
+    }
+    free(window.buffer);
+    return found;
+}
@@ -0,0 +1,11 @@
+#ifndef ZIP_SCAN_H
+#define ZIP_SCAN_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+typedef void (*zip_entry_callback)(void* ctx, off_t offset, const char* name, size_t name_len);
+
+int scan_local_headers(FILE* file, off_t start, off_t file_size, zip_entry_callback on_entry, void* ctx);
+
+#endif
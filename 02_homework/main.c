@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include <cjson/cJSON.h>
 #include <curl/curl.h>
 #include <stdlib.h>
@@ -18,21 +19,60 @@ typedef struct {
   string wind_direction;
 } wttr;
 
-const string base_url = "https://wttr.in/";
+typedef struct {
+  CURL *curl;
+  string city;
+  string url;
+  string_buffer buffer;
+} fetch_slot;
+
+typedef struct {
+  string base_url;
+  long concurrency;
+} fetch_options;
+
+#define DEFAULT_BASE_URL "https://wttr.in/"
+#define DEFAULT_CONCURRENCY 16
+#define INITIAL_CAPACITY 4096
+#define MAX_PRESIZE (16 * 1024 * 1024)
+
 const string query_param = "?format=j1";
-const int base_url_len = strlen(base_url);
-const int query_param_len = strlen(query_param);
+
+int buffer_reserve(string_buffer *buffer, size_t needed) {
+  if (needed <= buffer->capacity) {
+    return EXIT_SUCCESS;
+  }
+  size_t capacity = buffer->capacity ? buffer->capacity : INITIAL_CAPACITY;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+  string data = realloc(buffer->data, capacity);
+  if (data == NULL) {
+    return EXIT_FAILURE;
+  }
+  buffer->data = data;
+  buffer->capacity = capacity;
+  return EXIT_SUCCESS;
+}
 
 size_t write_callback(void *ptr, size_t size, size_t nmemb, void *data) {
   size_t total_size = size * nmemb;
-  string_buffer *buffer = (string_buffer *)data;
-  if (buffer->length + total_size >= buffer->capacity) {
-    printf("Buffer overflow!\n");
+  fetch_slot *slot = (fetch_slot *)data;
+  string_buffer *buffer = &slot->buffer;
+  if (buffer->length == 0) {
+    curl_off_t content_length = -1;
+    if (curl_easy_getinfo(slot->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                          &content_length) == CURLE_OK &&
+        content_length > 0 && content_length <= MAX_PRESIZE) {
+      buffer_reserve(buffer, (size_t)content_length);
+    }
+  }
+  if (buffer_reserve(buffer, buffer->length + total_size) != EXIT_SUCCESS) {
+    printf("Out of memory!\n");
     return 0;
   }
   memcpy(buffer->data + buffer->length, ptr, total_size);
   buffer->length += total_size;
-  buffer->data[buffer->length] = '\0';
   return total_size;
 }
 
@@ -55,8 +95,8 @@ string get_string_safe(cJSON *obj, string key) {
   return (cJSON_IsString(item) && item->valuestring) ? item->valuestring : NULL;
 }
 
-wttr *get_wttr_from_json(string buffer) {
-  cJSON *json = cJSON_Parse(buffer);
+wttr *get_wttr_from_json(const string_buffer *buffer) {
+  cJSON *json = cJSON_ParseWithLength(buffer->data, buffer->length);
   if (json == NULL) {
     return NULL;
   }
@@ -127,56 +167,253 @@ wttr *get_wttr_from_json(string buffer) {
   return wttr_result;
 }
 
-int get_api_wttr(CURL *curl, string city) {
-  string_buffer buffer;
-  buffer.capacity = 90000;
-  buffer.length = 0;
-  buffer.data = malloc(buffer.capacity);
-  if (buffer.data == NULL) {
+void report_result(fetch_slot *slot, CURLcode res) {
+  printf("City: %s\n", slot->city);
+  long status = 0;
+  curl_easy_getinfo(slot->curl, CURLINFO_RESPONSE_CODE, &status);
+  if (res != CURLE_OK) {
+    printf("Ошибка: %s\n", curl_easy_strerror(res));
+    return;
+  }
+  if (status != 200) {
+    printf("Ошибка: HTTP %ld\n", status);
+    return;
+  }
+  wttr *wttr_result = get_wttr_from_json(&slot->buffer);
+  if (wttr_result == NULL) {
+    printf("Something went wrong when parsing json\n");
+    return;
+  }
+  wttr_pprintln(wttr_result);
+  clean_wttr(wttr_result);
+}
+
+int start_request(CURLM *multi, fetch_slot *slot, string city,
+                  const fetch_options *options) {
+  string escaped = curl_easy_escape(slot->curl, city, 0);
+  if (escaped == NULL) {
     return EXIT_FAILURE;
   }
-  buffer.data[0] = '\0';
-  string full_url = malloc(base_url_len + strlen(city) + query_param_len + 1);
-  if (full_url == NULL) {
-    free(buffer.data);
+  free(slot->url);
+  slot->url = malloc(strlen(options->base_url) + strlen(escaped) +
+                     strlen(query_param) + 1);
+  if (slot->url == NULL) {
+    curl_free(escaped);
     return EXIT_FAILURE;
   }
-  strcpy(full_url, base_url);
-  strcat(full_url, city);
-  strcat(full_url, query_param);
-  curl_easy_setopt(curl, CURLOPT_URL, full_url);
-  curl_easy_setopt(curl, CURLOPT_USERAGENT, "curl/7.68.0");
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-  CURLcode res = curl_easy_perform(curl);
-  if (res != CURLE_OK) {
-    printf("Ошибка: %s\n", curl_easy_strerror(res));
-  } else {
-    wttr *wttr_result = get_wttr_from_json(buffer.data);
-    if (wttr_result == NULL) {
-      printf("Something went wrong when parsing json");
-    } else {
-      wttr_pprintln(wttr_result);
-      clean_wttr(wttr_result);
+  strcpy(slot->url, options->base_url);
+  strcat(slot->url, escaped);
+  strcat(slot->url, query_param);
+  curl_free(escaped);
+
+  slot->city = city;
+  slot->buffer.length = 0;
+  curl_easy_setopt(slot->curl, CURLOPT_URL, slot->url);
+  return curl_multi_add_handle(multi, slot->curl) == CURLM_OK ? EXIT_SUCCESS
+                                                              : EXIT_FAILURE;
+}
+
+int start_next(CURLM *multi, fetch_slot *slot, string *cities, size_t count,
+               size_t *next_city, const fetch_options *options) {
+  while (*next_city < count) {
+    string city = cities[(*next_city)++];
+    if (start_request(multi, slot, city, options) == EXIT_SUCCESS) {
+      return EXIT_SUCCESS;
     }
+    printf("City: %s\nОшибка: could not start request\n", city);
   }
-  free(full_url);
-  free(buffer.data);
-  return 0;
+  return EXIT_FAILURE;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2) {
-    printf("USAGE: %s <file>\n", argv[0]);
+int init_slot(fetch_slot *slot) {
+  slot->curl = curl_easy_init();
+  slot->url = NULL;
+  slot->city = NULL;
+  slot->buffer.capacity = 0;
+  slot->buffer.length = 0;
+  slot->buffer.data = NULL;
+  if (slot->curl == NULL) {
     return EXIT_FAILURE;
   }
-  string city = argv[1];
-  CURL *curl = curl_easy_init();
-  if (curl == NULL) {
+  curl_easy_setopt(slot->curl, CURLOPT_USERAGENT, "curl/7.68.0");
+  curl_easy_setopt(slot->curl, CURLOPT_WRITEFUNCTION, write_callback);
+  curl_easy_setopt(slot->curl, CURLOPT_WRITEDATA, slot);
+  curl_easy_setopt(slot->curl, CURLOPT_PRIVATE, slot);
+  curl_easy_setopt(slot->curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+  curl_easy_setopt(slot->curl, CURLOPT_PIPEWAIT, 1L);
+  curl_easy_setopt(slot->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(slot->curl, CURLOPT_ACCEPT_ENCODING, "");
+  return EXIT_SUCCESS;
+}
+
+void clean_slot(fetch_slot *slot) {
+  if (slot->curl != NULL) {
+    curl_easy_cleanup(slot->curl);
+  }
+  free(slot->url);
+  free(slot->buffer.data);
+}
+
+int get_api_wttr_many(string *cities, size_t count,
+                      const fetch_options *options) {
+  size_t slot_count =
+      count < (size_t)options->concurrency ? count : (size_t)options->concurrency;
+  fetch_slot *slots = calloc(slot_count, sizeof(fetch_slot));
+  CURLM *multi = curl_multi_init();
+  int status = slots != NULL && multi != NULL ? EXIT_SUCCESS : EXIT_FAILURE;
+  for (size_t i = 0; status == EXIT_SUCCESS && i < slot_count; i++) {
+    status = init_slot(&slots[i]);
+  }
+  if (status != EXIT_SUCCESS) {
     printf("Something went wrong when curl init");
+  } else {
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, options->concurrency);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, options->concurrency);
+    curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, options->concurrency);
+  }
+
+  size_t next_city = 0;
+  size_t active = 0;
+  for (size_t i = 0; status == EXIT_SUCCESS && i < slot_count; i++) {
+    if (start_next(multi, &slots[i], cities, count, &next_city, options) ==
+        EXIT_SUCCESS) {
+      active++;
+    }
+  }
+  while (active > 0) {
+    int running = 0;
+    if (curl_multi_perform(multi, &running) != CURLM_OK) {
+      status = EXIT_FAILURE;
+      break;
+    }
+    CURLMsg *msg;
+    int queued;
+    while ((msg = curl_multi_info_read(multi, &queued)) != NULL) {
+      if (msg->msg != CURLMSG_DONE) {
+        continue;
+      }
+      fetch_slot *slot = NULL;
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&slot);
+      CURLcode res = msg->data.result;
+      curl_multi_remove_handle(multi, slot->curl);
+      active--;
+      report_result(slot, res);
+      if (start_next(multi, slot, cities, count, &next_city, options) ==
+          EXIT_SUCCESS) {
+        active++;
+      }
+    }
+    if (active > 0 && curl_multi_poll(multi, NULL, 0, 1000, NULL) != CURLM_OK) {
+      status = EXIT_FAILURE;
+      break;
+    }
+  }
+
+  for (size_t i = 0; slots != NULL && i < slot_count; i++) {
+    if (slots[i].curl != NULL) {
+      curl_multi_remove_handle(multi, slots[i].curl);
+    }
+    clean_slot(&slots[i]);
+  }
+  free(slots);
+  if (multi != NULL) {
+    curl_multi_cleanup(multi);
+  }
+  return status;
+}
+
+int read_cities(const char *path, string **cities, size_t *count) {
+  FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+  if (file == NULL) {
+    return EXIT_FAILURE;
+  }
+  char line[256];
+  int status = EXIT_SUCCESS;
+  while (status == EXIT_SUCCESS && fgets(line, sizeof(line), file) != NULL) {
+    size_t len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    if (len == 0) {
+      continue;
+    }
+    string *grown = realloc(*cities, (*count + 1) * sizeof(string));
+    string copy = strdup(line);
+    if (grown == NULL || copy == NULL) {
+      free(copy);
+      if (grown != NULL) {
+        *cities = grown;
+      }
+      status = EXIT_FAILURE;
+      break;
+    }
+    *cities = grown;
+    (*cities)[(*count)++] = copy;
+  }
+  if (file != stdin) {
+    fclose(file);
+  }
+  return status;
+}
+
+int parse_concurrency(const char *text, long *out) {
+  char *endptr = NULL;
+  long value = strtol(text, &endptr, 10);
+  if (endptr == text || *endptr != '\0' || value <= 0) {
+    return EXIT_FAILURE;
+  }
+  *out = value;
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  fetch_options options = {DEFAULT_BASE_URL, DEFAULT_CONCURRENCY};
+  string *cities = NULL;
+  size_t count = 0;
+  size_t owned = 0;
+  const char *cities_file = NULL;
+  int usage_error = 0;
+  for (int i = 1; i < argc && !usage_error; i++) {
+    if (strcmp(argv[i], "--base-url") == 0 && i + 1 < argc) {
+      options.base_url = argv[++i];
+    } else if (strcmp(argv[i], "--concurrency") == 0 && i + 1 < argc) {
+      usage_error = parse_concurrency(argv[++i], &options.concurrency);
+    } else if (strcmp(argv[i], "--cities") == 0 && i + 1 < argc) {
+      cities_file = argv[++i];
+    } else if (strncmp(argv[i], "--", 2) == 0) {
+      usage_error = 1;
+    } else {
+      string *grown = realloc(cities, (count + 1) * sizeof(string));
+      if (grown == NULL) {
+        usage_error = 1;
+        break;
+      }
+      cities = grown;
+      cities[count++] = argv[i];
+    }
+  }
+  if (!usage_error && cities_file != NULL) {
+    owned = count;
+    if (read_cities(cities_file, &cities, &count) != EXIT_SUCCESS) {
+      printf("Failed to read cities from %s\n", cities_file);
+      usage_error = 1;
+    }
+  }
+  if (usage_error || count == 0) {
+    printf("USAGE: %s [--base-url URL] [--concurrency N] [--cities FILE] "
+           "<city>...\n",
+           argv[0]);
+    for (size_t i = owned; cities_file != NULL && i < count; i++) {
+      free(cities[i]);
+    }
+    free(cities);
     return EXIT_FAILURE;
   }
-  printf("City: %s\n", city);
-  get_api_wttr(curl, city);
-  curl_easy_cleanup(curl);
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  int status = get_api_wttr_many(cities, count, &options);
+  curl_global_cleanup();
+  for (size_t i = owned; cities_file != NULL && i < count; i++) {
+    free(cities[i]);
+  }
+  free(cities);
+  return status;
 }
@@ -0,0 +1,62 @@
+#!/bin/sh
+# Runs the client against a local python3 http.server that serves a canned
+# wttr.in j1 response, so it can be checked without network access.
+set -eu
+
+SOLUTION=${SOLUTION:-./solution}
+PORT=${PORT:-8765}
+ROOT=$(mktemp -d)
+SERVER=
+
+cleanup() {
+  if [ -n "$SERVER" ]; then
+    kill "$SERVER" 2>/dev/null || true
+  fi
+  rm -rf "$ROOT"
+}
+trap cleanup EXIT INT TERM
+
+canned() {
+  cat > "$ROOT/$1" <<EOF
+{"current_condition": [{"temp_C": "$2", "windspeedKmph": "$3", "winddir16Point": "$4",
+  "weatherDesc": [{"value": "$5"}]}]}
+EOF
+}
+
+canned Moscow -3 11 NNW Snow
+canned London 9 20 SW "Light rain"
+canned Paris 14 7 E Sunny
+printf 'not json' > "$ROOT/Broken"
+
+python3 -m http.server "$PORT" --bind 127.0.0.1 --directory "$ROOT" >/dev/null 2>&1 &
+SERVER=$!
+for _ in 1 2 3 4 5 6 7 8 9 10; do
+  if python3 -c "import socket; socket.create_connection(('127.0.0.1', $PORT), 1)" 2>/dev/null; then
+    break
+  fi
+  sleep 0.2
+done
+
+OUTPUT=$("$SOLUTION" --base-url "http://127.0.0.1:$PORT/" --concurrency 2 \
+  Moscow London Nowhere Broken Paris)
+printf '%s\n' "$OUTPUT"
+
+status=0
+expect() {
+  if ! printf '%s\n' "$OUTPUT" | grep -qF -- "$1"; then
+    echo "FAIL: missing '$1'" >&2
+    status=1
+  fi
+}
+
+expect "Temperature: -3"
+expect "Description: Light rain"
+expect "Wind direction: E"
+expect "Ошибка: HTTP 404"
+expect "Something went wrong when parsing json"
+if [ "$(printf '%s\n' "$OUTPUT" | grep -c '^City: ')" -ne 5 ]; then
+  echo "FAIL: expected a result for every city" >&2
+  status=1
+fi
+[ "$status" -eq 0 ] && echo "PASS"
+exit "$status"
@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "batch.h"
+
+typedef struct {
+    batch_list* list;
+    input_backend backend;
+    atomic_size_t next;
+    size_t printed;
+    size_t failures;
+    size_t mismatches;
+    pthread_mutex_t lock;
+} batch_pool;
+
+void batch_init(batch_list* list, const checksum_algorithm* algo){
+    memset(list, 0, sizeof(*list));
+    list->algo = algo;
+}
+
+static int push_entry(batch_list* list, const char* path, uint64_t expected, int error){
+    if (list->count == list->capacity){
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        batch_entry* grown = realloc(list->entries, capacity * sizeof(batch_entry));
+        if (grown == NULL){
+            return -1;
+        }
+        list->entries = grown;
+        list->capacity = capacity;
+    }
+    char* copy = strdup(path);
+    if (copy == NULL){
+        return -1;
+    }
+    batch_entry* entry = &list->entries[list->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->path = copy;
+    entry->expected = expected;
+    entry->error = error;
+    return 0;
+}
+
+static int skip_dots(const struct dirent* entry){
+    return strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0;
+}
+
+static int add_directory(batch_list* list, const char* path){
+    struct dirent** names = NULL;
+    int count = scandir(path, &names, skip_dots, alphasort);
+    if (count < 0){
+        return push_entry(list, path, 0, errno);
+    }
+    int status = 0;
+    size_t path_len = strlen(path);
+    int needs_slash = path_len > 0 && path[path_len - 1] != '/';
+    for (int i = 0; i < count; i++){
+        size_t child_len = path_len + needs_slash + strlen(names[i]->d_name) + 1;
+        char* child = malloc(child_len);
+        if (child == NULL || status != 0){
+            free(child);
+            free(names[i]);
+            status = -1;
+            continue;
+        }
+        snprintf(child, child_len, "%s%s%s", path, needs_slash ? "/" : "", names[i]->d_name);
+        struct stat st;
+        if (lstat(child, &st) != 0){
+            status = push_entry(list, child, 0, errno);
+        } else if (S_ISDIR(st.st_mode)){
+            status = add_directory(list, child);
+        } else if (S_ISREG(st.st_mode) || (S_ISLNK(st.st_mode) && stat(child, &st) == 0 && S_ISREG(st.st_mode))){
+            status = push_entry(list, child, 0, 0);
+        }
+        free(child);
+        free(names[i]);
+    }
+    free(names);
+    return status;
+}
+
+int batch_add_path(batch_list* list, const char* path){
+    struct stat st;
+    if (stat(path, &st) != 0){
+        return push_entry(list, path, 0, errno);
+    }
+    if (S_ISDIR(st.st_mode)){
+        return add_directory(list, path);
+    }
+    return push_entry(list, path, 0, 0);
+}
+
+static int parse_manifest_line(char* line, int width, uint64_t* digest, char** path){
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')){
+        line[--len] = '\0';
+    }
+    if (len < (size_t)width + 3 || line[width] != ' ' || (line[width + 1] != ' ' && line[width + 1] != '*')){
+        return -1;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < width; i++){
+        char c = line[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return -1;
+        value = (value << 4) | (uint64_t)digit;
+    }
+    *digest = value;
+    *path = line + width + 2;
+    return 0;
+}
+
+int batch_load_manifest(batch_list* list, const char* manifest){
+    FILE* file = strcmp(manifest, "-") == 0 ? stdin : fopen(manifest, "r");
+    if (file == NULL){
+        return -1;
+    }
+    list->check = 1;
+    char* line = NULL;
+    size_t capacity = 0;
+    int status = 0;
+    while (status == 0 && getline(&line, &capacity, file) != -1){
+        uint64_t digest;
+        char* path;
+        if (parse_manifest_line(line, list->algo->digest_size * 2, &digest, &path) != 0){
+            list->malformed++;
+            continue;
+        }
+        status = push_entry(list, path, digest, 0);
+    }
+    if (ferror(file)){
+        status = -1;
+    }
+    free(line);
+    if (file != stdin){
+        fclose(file);
+    }
+    return status;
+}
+
+static void checksum_block(void* ctx, const unsigned char* data, size_t len){
+    checksum_update((checksum_ctx*)ctx, data, len);
+}
+
+static void print_entry(batch_pool* pool, batch_entry* entry){
+    if (entry->error){
+        fprintf(stderr, "%s: %s\n", entry->path, strerror(entry->error));
+        if (pool->list->check){
+            printf("%s: FAILED open or read\n", entry->path);
+        }
+        pool->failures++;
+    } else if (pool->list->check){
+        int ok = entry->digest == entry->expected;
+        printf("%s: %s\n", entry->path, ok ? "OK" : "FAILED");
+        pool->mismatches += !ok;
+    } else {
+        printf("%0*llx  %s\n", pool->list->algo->digest_size * 2, (unsigned long long)entry->digest, entry->path);
+    }
+    free(entry->path);
+    entry->path = NULL;
+}
+
+static void finish_entry(batch_pool* pool, batch_entry* entry){
+    pthread_mutex_lock(&pool->lock);
+    entry->done = 1;
+    batch_list* list = pool->list;
+    while (pool->printed < list->count && list->entries[pool->printed].done){
+        print_entry(pool, &list->entries[pool->printed++]);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void* batch_worker(void* arg){
+    batch_pool* pool = (batch_pool*)arg;
+    batch_list* list = pool->list;
+    for (;;){
+        size_t index = atomic_fetch_add(&pool->next, 1);
+        if (index >= list->count){
+            break;
+        }
+        batch_entry* entry = &list->entries[index];
+        if (entry->error == 0){
+            checksum_ctx ctx;
+            checksum_init(&ctx, list->algo);
+            errno = 0;
+            if (read_file(entry->path, pool->backend, checksum_block, &ctx) != 0){
+                entry->error = errno ? errno : EIO;
+            }
+            entry->digest = checksum_final(&ctx);
+        }
+        finish_entry(pool, entry);
+    }
+    return NULL;
+}
+
+int batch_run(batch_list* list, size_t threads, input_backend backend){
+    batch_pool pool;
+    pool.list = list;
+    pool.backend = backend;
+    pool.printed = 0;
+    pool.failures = 0;
+    pool.mismatches = 0;
+    atomic_init(&pool.next, 0);
+    pthread_mutex_init(&pool.lock, NULL);
+    for (size_t i = 0; i < list->count; i++){
+        list->entries[i].done = 0;
+    }
+    if (threads > list->count){
+        threads = list->count > 0 ? list->count : 1;
+    }
+
+    pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+    size_t started = 0;
+    for (size_t i = 0; workers && i < threads; i++){
+        if (pthread_create(&workers[i], NULL, batch_worker, &pool) != 0){
+            break;
+        }
+        started++;
+    }
+    if (started == 0){
+        batch_worker(&pool);
+    }
+    for (size_t i = 0; i < started; i++){
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    pthread_mutex_destroy(&pool.lock);
+    fflush(stdout);
+
+    if (list->malformed){
+        fprintf(stderr, "WARNING: %zu line%s improperly formatted\n", list->malformed, list->malformed == 1 ? " is" : "s are");
+    }
+    if (list->check && pool.failures){
+        fprintf(stderr, "WARNING: %zu listed file%s could not be read\n", pool.failures, pool.failures == 1 ? "" : "s");
+    }
+    if (pool.mismatches){
+        fprintf(stderr, "WARNING: %zu computed checksum%s did NOT match\n", pool.mismatches, pool.mismatches == 1 ? "" : "s");
+    }
+    if (list->check && list->count == 0){
+        fprintf(stderr, "no properly formatted checksum lines found\n");
+        return 1;
+    }
+    return (int)(pool.failures + pool.mismatches > 0);
+}
+
+void batch_free(batch_list* list){
+    for (size_t i = 0; i < list->count; i++){
+        free(list->entries[i].path);
+    }
+    free(list->entries);
+    batch_init(list, list->algo);
+}
@@ -0,0 +1,32 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "input.h"
+#include "checksum.h"
+
+typedef struct {
+    char* path;
+    uint64_t expected;
+    uint64_t digest;
+    int error;
+    int done;
+} batch_entry;
+
+typedef struct {
+    batch_entry* entries;
+    size_t count;
+    size_t capacity;
+    size_t malformed;
+    int check;
+    const checksum_algorithm* algo;
+} batch_list;
+
+void batch_init(batch_list* list, const checksum_algorithm* algo);
+int batch_add_path(batch_list* list, const char* path);
+int batch_load_manifest(batch_list* list, const char* manifest);
+int batch_run(batch_list* list, size_t threads, input_backend backend);
+void batch_free(batch_list* list);
+
+#endif
@@ -0,0 +1,70 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "crc32.h"
+#include "checksum.h"
+
+#define BUFFER_SIZE (64 * 1024 * 1024)
+#define ROUNDS 5
+
+static const char* const impl_names[] = { "reference", "slice8", "slice16", "pclmul" };
+static const char* const algo_names[] = { "crc32", "crc32c", "xxh64", "xxh3" };
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    unsigned char* buffer = malloc(BUFFER_SIZE);
+    if (buffer == NULL) {
+        return 1;
+    }
+    unsigned seed = 42;
+    for (size_t i = 0; i < BUFFER_SIZE; i++) {
+        buffer[i] = (unsigned char)rand_r(&seed);
+    }
+    crc32_init();
+    crc32_use_impl(crc32_find_impl("reference"));
+    uint32_t expected = crc32_update(0, buffer + 3, BUFFER_SIZE - 3);
+    int status = 0;
+    for (size_t n = 0; n < sizeof(impl_names) / sizeof(impl_names[0]); n++) {
+        const crc32_impl* impl = crc32_find_impl(impl_names[n]);
+        if (impl == NULL || !impl->supported()) {
+            printf("%-10s unsupported\n", impl_names[n]);
+            continue;
+        }
+        crc32_use_impl(impl);
+        int rounds = strcmp(impl->name, "reference") == 0 ? 1 : ROUNDS;
+        uint32_t crc = 0;
+        double start = now_seconds();
+        for (int r = 0; r < rounds; r++) {
+            crc = crc32_update(0, buffer + 3, BUFFER_SIZE - 3);
+        }
+        double elapsed = now_seconds() - start;
+        printf("%-10s %8.1f MB/s  (crc %08X%s)\n", impl->name,
+            (double)(BUFFER_SIZE - 3) * rounds / elapsed / (1024 * 1024), crc, crc == expected ? "" : ", MISMATCH");
+        if (crc != expected) {
+            status = 1;
+        }
+    }
+    crc32_use_impl(crc32_best_impl());
+    for (size_t n = 0; n < sizeof(algo_names) / sizeof(algo_names[0]); n++) {
+        const checksum_algorithm* algo = checksum_find(algo_names[n]);
+        checksum_ctx ctx;
+        double start = now_seconds();
+        for (int r = 0; r < ROUNDS; r++) {
+            checksum_init(&ctx, algo);
+            checksum_update(&ctx, buffer + 3, BUFFER_SIZE - 3);
+        }
+        double elapsed = now_seconds() - start;
+        printf("%-10s %8.1f MB/s  (%0*llx)\n", algo->name,
+            (double)(BUFFER_SIZE - 3) * ROUNDS / elapsed / (1024 * 1024), algo->digest_size * 2, (unsigned long long)checksum_final(&ctx));
+    }
+    free(buffer);
+    return status;
+}
@@ -0,0 +1,76 @@
+#include <string.h>
+#include "checksum.h"
+#include "crc32.h"
+
+static void crc_init(checksum_ctx* ctx){
+    ctx->u.crc = 0;
+}
+
+static uint64_t crc_final(const checksum_ctx* ctx){
+    return ctx->u.crc;
+}
+
+static void crc32_stream(checksum_ctx* ctx, const void* data, size_t len){
+    ctx->u.crc = crc32_update(ctx->u.crc, data, len);
+}
+
+static void crc32c_stream(checksum_ctx* ctx, const void* data, size_t len){
+    ctx->u.crc = crc32c_update(ctx->u.crc, data, len);
+}
+
+static void xxh64_start(checksum_ctx* ctx){
+    xxh64_init(&ctx->u.xxh64);
+}
+
+static void xxh64_stream(checksum_ctx* ctx, const void* data, size_t len){
+    xxh64_update(&ctx->u.xxh64, data, len);
+}
+
+static uint64_t xxh64_final(const checksum_ctx* ctx){
+    return xxh64_digest(&ctx->u.xxh64);
+}
+
+static void xxh3_start(checksum_ctx* ctx){
+    xxh3_init(&ctx->u.xxh3);
+}
+
+static void xxh3_stream(checksum_ctx* ctx, const void* data, size_t len){
+    xxh3_update(&ctx->u.xxh3, data, len);
+}
+
+static uint64_t xxh3_final(const checksum_ctx* ctx){
+    return xxh3_digest(&ctx->u.xxh3);
+}
+
+static const checksum_algorithm algorithms[] = {
+    { "crc32", "CRC32", 4, crc_init, crc32_stream, crc_final },
+    { "crc32c", "CRC32C", 4, crc_init, crc32c_stream, crc_final },
+    { "xxh64", "XXH64", 8, xxh64_start, xxh64_stream, xxh64_final },
+    { "xxh3", "XXH3", 8, xxh3_start, xxh3_stream, xxh3_final },
+};
+
+const checksum_algorithm* checksum_find(const char* name){
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++){
+        if (strcmp(algorithms[i].name, name) == 0){
+            return &algorithms[i];
+        }
+    }
+    return NULL;
+}
+
+const checksum_algorithm* checksum_default(void){
+    return &algorithms[0];
+}
+
+void checksum_init(checksum_ctx* ctx, const checksum_algorithm* algo){
+    ctx->algo = algo;
+    algo->init(ctx);
+}
+
+void checksum_update(checksum_ctx* ctx, const void* data, size_t len){
+    ctx->algo->update(ctx, data, len);
+}
+
+uint64_t checksum_final(const checksum_ctx* ctx){
+    return ctx->algo->final(ctx);
+}
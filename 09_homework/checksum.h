@@ -0,0 +1,34 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xxhash.h"
+
+typedef struct checksum_ctx checksum_ctx;
+
+typedef struct {
+    const char* name;
+    const char* label;
+    int digest_size;
+    void (*init)(checksum_ctx* ctx);
+    void (*update)(checksum_ctx* ctx, const void* data, size_t len);
+    uint64_t (*final)(const checksum_ctx* ctx);
+} checksum_algorithm;
+
+struct checksum_ctx {
+    const checksum_algorithm* algo;
+    union {
+        uint32_t crc;
+        xxh64_state xxh64;
+        xxh3_state xxh3;
+    } u;
+};
+
+const checksum_algorithm* checksum_find(const char* name);
+const checksum_algorithm* checksum_default(void);
+void checksum_init(checksum_ctx* ctx, const checksum_algorithm* algo);
+void checksum_update(checksum_ctx* ctx, const void* data, size_t len);
+uint64_t checksum_final(const checksum_ctx* ctx);
+
+#endif
@@ -0,0 +1,285 @@
+#include <string.h>
+#include "crc32.h"
+#include "crc32_tables.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_X86 1
+#endif
+
+#define CRC32_POLY 0xEDB88320
+#define PCLMUL_MIN_LEN 64
+
+static uint32_t multmodp(uint32_t a, uint32_t b){
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+    for (;;){
+        if (a & m){
+            p ^= b;
+            if ((a & (m - 1)) == 0){
+                break;
+            }
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ CRC32_POLY : b >> 1;
+    }
+    return p;
+}
+
+static uint32_t x2nmodp(uint64_t n, unsigned k){
+    uint32_t p = (uint32_t)1 << 31;
+    while (n){
+        if (n & 1){
+            p = multmodp(x2n_table[k & 31], p);
+        }
+        n >>= 1;
+        k++;
+    }
+    return p;
+}
+
+static inline uint32_t load_le32(const unsigned char* p){
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline uint32_t bytewise(const uint32_t (*t)[256], uint32_t crc, const unsigned char* buf, size_t len){
+    for (size_t i = 0; i < len; i++){
+        crc = (crc >> 8) ^ t[0][(crc ^ buf[i]) & 0xFF];
+    }
+    return crc;
+}
+
+static inline uint32_t slice8(const uint32_t (*t)[256], uint32_t crc, const unsigned char* buf, size_t len){
+    while (len >= 8){
+        uint32_t lo = load_le32(buf) ^ crc;
+        uint32_t hi = load_le32(buf + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+    return bytewise(t, crc, buf, len);
+}
+
+static uint32_t crc32_reference(uint32_t crc, const unsigned char* buf, size_t len){
+    return bytewise(crc_tables, crc, buf, len);
+}
+
+static uint32_t crc32_slice8(uint32_t crc, const unsigned char* buf, size_t len){
+    return slice8(crc_tables, crc, buf, len);
+}
+
+static uint32_t crc32_slice16(uint32_t crc, const unsigned char* buf, size_t len){
+    const uint32_t (*t)[256] = crc_tables;
+    while (len >= 16){
+        uint32_t a = load_le32(buf) ^ crc;
+        uint32_t b = load_le32(buf + 4);
+        uint32_t c = load_le32(buf + 8);
+        uint32_t d = load_le32(buf + 12);
+        crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^ t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24] ^
+              t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^ t[9][(b >> 16) & 0xFF] ^ t[8][b >> 24] ^
+              t[7][c & 0xFF] ^ t[6][(c >> 8) & 0xFF] ^ t[5][(c >> 16) & 0xFF] ^ t[4][c >> 24] ^
+              t[3][d & 0xFF] ^ t[2][(d >> 8) & 0xFF] ^ t[1][(d >> 16) & 0xFF] ^ t[0][d >> 24];
+        buf += 16;
+        len -= 16;
+    }
+    return crc32_slice8(crc, buf, len);
+}
+
+static int always_supported(void){
+    return 1;
+}
+
+#ifdef CRC32_X86
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_pclmul_blocks(uint32_t crc, const unsigned char* buf, size_t len){
+    static const uint64_t k1k2[2] __attribute__((aligned(16))) = { 0x0154442bd4, 0x01c6e41596 };
+    static const uint64_t k3k4[2] __attribute__((aligned(16))) = { 0x01751997d0, 0x00ccaa009e };
+    static const uint64_t k5k0[2] __attribute__((aligned(16))) = { 0x0163cd6124, 0x0000000000 };
+    static const uint64_t poly[2] __attribute__((aligned(16))) = { 0x01db710641, 0x01f7011641 };
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    x0 = _mm_load_si128((const __m128i*)k1k2);
+    buf += 64;
+    len -= 64;
+
+    while (len >= 64){
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        buf += 64;
+        len -= 64;
+    }
+
+    x0 = _mm_load_si128((const __m128i*)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (len >= 16){
+        x2 = _mm_loadu_si128((const __m128i*)buf);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        buf += 16;
+        len -= 16;
+    }
+
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_load_si128((const __m128i*)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+static uint32_t crc32_pclmul(uint32_t crc, const unsigned char* buf, size_t len){
+    if (len >= PCLMUL_MIN_LEN){
+        size_t blocks = len & ~(size_t)15;
+        crc = crc32_pclmul_blocks(crc, buf, blocks);
+        buf += blocks;
+        len -= blocks;
+    }
+    return crc32_slice16(crc, buf, len);
+}
+
+static int pclmul_supported(void){
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char* buf, size_t len){
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    while (len >= 8){
+        uint64_t word;
+        memcpy(&word, buf, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        buf += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+    while (len >= 4){
+        crc = _mm_crc32_u32(crc, load_le32(buf));
+        buf += 4;
+        len -= 4;
+    }
+    while (len > 0){
+        crc = _mm_crc32_u8(crc, *buf++);
+        len--;
+    }
+    return crc;
+}
+
+static int sse42_supported(void){
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+static uint32_t crc32c_slice8(uint32_t crc, const unsigned char* buf, size_t len){
+    return slice8(crc32c_tables, crc, buf, len);
+}
+
+static const crc32_impl impls[] = {
+#ifdef CRC32_X86
+    { "pclmul", crc32_pclmul, pclmul_supported },
+#endif
+    { "slice16", crc32_slice16, always_supported },
+    { "slice8", crc32_slice8, always_supported },
+    { "reference", crc32_reference, always_supported },
+};
+
+static const crc32_impl* active_impl = NULL;
+static crc32_kernel crc32c_kernel = crc32c_slice8;
+
+void crc32_init(void){
+#ifdef CRC32_X86
+    if (sse42_supported()){
+        crc32c_kernel = crc32c_sse42;
+    }
+#endif
+    if (active_impl == NULL){
+        active_impl = crc32_best_impl();
+    }
+}
+
+const crc32_impl* crc32_find_impl(const char* name){
+    for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++){
+        if (strcmp(impls[i].name, name) == 0){
+            return &impls[i];
+        }
+    }
+    return NULL;
+}
+
+const crc32_impl* crc32_best_impl(void){
+    for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++){
+        if (impls[i].supported()){
+            return &impls[i];
+        }
+    }
+    return &impls[sizeof(impls) / sizeof(impls[0]) - 1];
+}
+
+void crc32_use_impl(const crc32_impl* impl){
+    active_impl = impl;
+}
+
+const char* crc32_impl_name(void){
+    return active_impl->name;
+}
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len){
+    return ~active_impl->update(~crc, data, len);
+}
+
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len){
+    return ~crc32c_kernel(~crc, data, len);
+}
+
+uint32_t crc32_join(uint32_t crc1, uint32_t crc2, uint64_t len2){
+    return multmodp(x2nmodp(len2, 3), crc1) ^ crc2;
+}
@@ -0,0 +1,24 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t (*crc32_kernel)(uint32_t crc, const unsigned char* buf, size_t len);
+
+typedef struct {
+    const char* name;
+    crc32_kernel update;
+    int (*supported)(void);
+} crc32_impl;
+
+void crc32_init(void);
+const crc32_impl* crc32_find_impl(const char* name);
+const crc32_impl* crc32_best_impl(void);
+void crc32_use_impl(const crc32_impl* impl);
+const char* crc32_impl_name(void);
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len);
+uint32_t crc32_join(uint32_t crc1, uint32_t crc2, uint64_t len2);
+
+#endif
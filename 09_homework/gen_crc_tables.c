@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#define CRC32_POLY 0xEDB88320
+#define CRC32C_POLY 0x82F63B78
+
+static uint32_t crc_tables[16][256];
+static uint32_t crc32c_tables[8][256];
+static uint32_t x2n_table[32];
+
+static void generate_slice_tables(uint32_t (*tables)[256], int count, uint32_t poly){
+    for (uint32_t i = 0; i < 256; i++){
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++){
+            crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
+        }
+        tables[0][i] = crc;
+    }
+    for (int k = 1; k < count; k++){
+        for (int i = 0; i < 256; i++){
+            uint32_t prev = tables[k - 1][i];
+            tables[k][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+}
+
+static uint32_t multmodp(uint32_t a, uint32_t b){
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+    for (;;){
+        if (a & m){
+            p ^= b;
+            if ((a & (m - 1)) == 0){
+                break;
+            }
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ CRC32_POLY : b >> 1;
+    }
+    return p;
+}
+
+static void generate_x2n_table(void){
+    uint32_t p = (uint32_t)1 << 30;
+    x2n_table[0] = p;
+    for (int n = 1; n < 32; n++){
+        x2n_table[n] = p = multmodp(p, p);
+    }
+}
+
+static void print_values(const uint32_t* values, int count, const char* indent){
+    for (int i = 0; i < count; i++){
+        printf("%s0x%08x%s", i % 8 == 0 ? indent : "", (unsigned)values[i],
+               i + 1 == count ? "" : i % 8 == 7 ? ",\n" : ", ");
+    }
+    printf("\n");
+}
+
+static void print_tables(const char* name, uint32_t (*tables)[256], int count){
+    printf("static const uint32_t %s[%d][256] = {\n", name, count);
+    for (int k = 0; k < count; k++){
+        printf("    {\n");
+        print_values(tables[k], 256, "        ");
+        printf("    }%s\n", k + 1 == count ? "" : ",");
+    }
+    printf("};\n\n");
+}
+
+int main(void){
+    generate_slice_tables(crc_tables, 16, CRC32_POLY);
+    generate_slice_tables(crc32c_tables, 8, CRC32C_POLY);
+    generate_x2n_table();
+
+    printf("/* Generated by gen_crc_tables.c, do not edit. */\n");
+    printf("#ifndef CRC32_TABLES_H\n#define CRC32_TABLES_H\n\n#include <stdint.h>\n\n");
+    print_tables("crc_tables", crc_tables, 16);
+    print_tables("crc32c_tables", crc32c_tables, 8);
+    printf("static const uint32_t x2n_table[32] = {\n");
+    print_values(x2n_table, 32, "    ");
+    printf("};\n\n#endif\n");
+    return 0;
+}
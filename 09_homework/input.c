@@ -0,0 +1,416 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+#include "input.h"
+
+#define BUFFER_SIZE (1024 * 1024 * 10)
+#define DIRECT_ALIGNMENT 4096
+#define DIRECT_BLOCK_SIZE (4 * 1024 * 1024)
+#define URING_BLOCK_SIZE (1024 * 1024)
+#define URING_DEPTH 8
+
+static const char* const backend_names[] = { "stdio", "mmap", "direct", "io_uring" };
+
+int parse_backend(const char* name, input_backend* out){
+    for (size_t i = 0; i < sizeof(backend_names) / sizeof(backend_names[0]); i++){
+        if (strcmp(backend_names[i], name) == 0){
+            *out = (input_backend)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* backend_name(input_backend backend){
+    return backend_names[backend];
+}
+
+static int read_stdio(const char* path, block_consumer consume, void* ctx){
+    FILE* file = fopen(path, "rb");
+    if (!file){
+        return -1;
+    }
+    size_t buffer_size = BUFFER_SIZE;
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size < BUFFER_SIZE){
+        buffer_size = (size_t)st.st_size + 1;
+    }
+    unsigned char *buffer = (unsigned char *)malloc(buffer_size);
+    if (buffer == NULL){
+        fclose(file);
+        return -1;
+    }
+    size_t bytes_read = 0;
+    while ((bytes_read = fread(buffer, 1, buffer_size, file)) > 0){
+        consume(ctx, buffer, bytes_read);
+    }
+    int failed = ferror(file);
+    free(buffer);
+    fclose(file);
+    return failed ? -1 : 0;
+}
+
+static int read_mmap(const char* path, block_consumer consume, void* ctx){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0){
+        close(fd);
+        return 0;
+    }
+    unsigned char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED){
+        return -1;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    for (size_t offset = 0; offset < size; offset += BUFFER_SIZE){
+        size_t len = size - offset < BUFFER_SIZE ? size - offset : BUFFER_SIZE;
+        consume(ctx, data + offset, len);
+    }
+    munmap(data, size);
+    return 0;
+}
+
+typedef struct {
+    int fd;
+    unsigned char* data[2];
+    ssize_t len[2];
+    int full[2];
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} double_buffer;
+
+static ssize_t read_block(int fd, unsigned char* buffer, size_t size){
+    size_t done = 0;
+    while (done < size){
+        ssize_t got = read(fd, buffer + done, size - done);
+        if (got < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0){
+            break;
+        }
+        done += (size_t)got;
+    }
+    return (ssize_t)done;
+}
+
+static void* direct_reader(void* arg){
+    double_buffer* db = (double_buffer*)arg;
+    for (int slot = 0;; slot ^= 1){
+        pthread_mutex_lock(&db->lock);
+        while (db->full[slot]){
+            pthread_cond_wait(&db->changed, &db->lock);
+        }
+        pthread_mutex_unlock(&db->lock);
+
+        ssize_t len = read_block(db->fd, db->data[slot], DIRECT_BLOCK_SIZE);
+
+        pthread_mutex_lock(&db->lock);
+        db->len[slot] = len;
+        db->full[slot] = 1;
+        pthread_cond_broadcast(&db->changed);
+        pthread_mutex_unlock(&db->lock);
+        if (len <= 0){
+            return NULL;
+        }
+    }
+}
+
+static int read_direct(const char* path, block_consumer consume, void* ctx){
+    int fd = open(path, O_RDONLY | O_DIRECT);
+    if (fd < 0 && errno == EINVAL){
+        fprintf(stderr, "O_DIRECT not supported for %s, using buffered reads\n", path);
+        fd = open(path, O_RDONLY);
+    }
+    if (fd < 0){
+        return -1;
+    }
+    double_buffer db = { .fd = fd };
+    for (int i = 0; i < 2; i++){
+        if (posix_memalign((void**)&db.data[i], DIRECT_ALIGNMENT, DIRECT_BLOCK_SIZE) != 0){
+            db.data[i] = NULL;
+        }
+    }
+    if (db.data[0] == NULL || db.data[1] == NULL){
+        free(db.data[0]);
+        free(db.data[1]);
+        close(fd);
+        return -1;
+    }
+    pthread_mutex_init(&db.lock, NULL);
+    pthread_cond_init(&db.changed, NULL);
+    pthread_t reader;
+    int started = pthread_create(&reader, NULL, direct_reader, &db) == 0;
+    int status = started ? 0 : -1;
+    for (int slot = 0; status == 0; slot ^= 1){
+        pthread_mutex_lock(&db.lock);
+        while (!db.full[slot]){
+            pthread_cond_wait(&db.changed, &db.lock);
+        }
+        ssize_t len = db.len[slot];
+        pthread_mutex_unlock(&db.lock);
+        if (len <= 0){
+            status = len < 0 ? -1 : 0;
+            break;
+        }
+        consume(ctx, db.data[slot], (size_t)len);
+
+        pthread_mutex_lock(&db.lock);
+        db.full[slot] = 0;
+        pthread_cond_broadcast(&db.changed);
+        pthread_mutex_unlock(&db.lock);
+    }
+    if (started){
+        pthread_join(reader, NULL);
+    }
+    pthread_mutex_destroy(&db.lock);
+    pthread_cond_destroy(&db.changed);
+    free(db.data[0]);
+    free(db.data[1]);
+    close(fd);
+    return status;
+}
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+typedef struct {
+    int fd;
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    unsigned pending;
+} uring;
+
+typedef struct {
+    unsigned char* buffer;
+    off_t offset;
+    size_t len;
+    size_t done;
+} uring_slot;
+
+static int uring_setup(uring* ring, unsigned entries){
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0){
+        return -1;
+    }
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && ring->cq_size > ring->sq_size){
+        ring->sq_size = ring->cq_size;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED){
+        close(ring->fd);
+        return -1;
+    }
+    ring->cq_ptr = ring->sq_ptr;
+    if (!single_mmap){
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED){
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED){
+        if (!single_mmap) munmap(ring->cq_ptr, ring->cq_size);
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->fd);
+        return -1;
+    }
+    char* sq = ring->sq_ptr;
+    char* cq = ring->cq_ptr;
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring->pending = 0;
+    return 0;
+}
+
+static void uring_teardown(uring* ring){
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr){
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+static int uring_submit_read(uring* ring, int fd, uring_slot* slot, unsigned index){
+    unsigned tail = *ring->sq_tail;
+    unsigned entry = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[entry];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)(slot->buffer + slot->done);
+    sqe->len = (uint32_t)(slot->len - slot->done);
+    sqe->off = (uint64_t)(slot->offset + (off_t)slot->done);
+    sqe->user_data = index;
+    ring->sq_array[entry] = entry;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    int submitted;
+    do {
+        submitted = (int)syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+    } while (submitted < 0 && errno == EINTR);
+    if (submitted != 1){
+        return -1;
+    }
+    ring->pending++;
+    return 0;
+}
+
+static int uring_reap(uring* ring, int fd, uring_slot* slots){
+    int waited;
+    do {
+        waited = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    } while (waited < 0 && errno == EINTR);
+    if (waited < 0){
+        return -1;
+    }
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    int status = 0;
+    for (; head != tail; head++){
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        ring->pending--;
+        if (slots == NULL){
+            continue;
+        }
+        unsigned index = (unsigned)cqe->user_data;
+        uring_slot* slot = &slots[index];
+        if (cqe->res == -EINTR || cqe->res == -EAGAIN){
+            status |= uring_submit_read(ring, fd, slot, index);
+        } else if (cqe->res <= 0){
+            status = -1;
+        } else {
+            slot->done += (size_t)cqe->res;
+            if (slot->done < slot->len){
+                status |= uring_submit_read(ring, fd, slot, index);
+            }
+        }
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return status;
+}
+
+static int read_io_uring(const char* path, block_consumer consume, void* ctx){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        close(fd);
+        return -1;
+    }
+    uring ring;
+    if (uring_setup(&ring, URING_DEPTH) != 0){
+        fprintf(stderr, "io_uring unavailable (%s), using stdio\n", strerror(errno));
+        close(fd);
+        return read_stdio(path, consume, ctx);
+    }
+    uring_slot slots[URING_DEPTH];
+    unsigned char* buffers = malloc((size_t)URING_DEPTH * URING_BLOCK_SIZE);
+    int status = buffers ? 0 : -1;
+    off_t size = st.st_size;
+    off_t next_offset = 0;
+    size_t in_flight = 0;
+    for (unsigned i = 0; i < URING_DEPTH && status == 0 && next_offset < size; i++){
+        slots[i].buffer = buffers + (size_t)i * URING_BLOCK_SIZE;
+        slots[i].offset = next_offset;
+        slots[i].len = size - next_offset < URING_BLOCK_SIZE ? (size_t)(size - next_offset) : URING_BLOCK_SIZE;
+        slots[i].done = 0;
+        next_offset += (off_t)slots[i].len;
+        status = uring_submit_read(&ring, fd, &slots[i], i);
+        in_flight += status == 0;
+    }
+    for (size_t block = 0; status == 0 && in_flight > 0; block++){
+        unsigned index = (unsigned)(block % URING_DEPTH);
+        uring_slot* slot = &slots[index];
+        while (status == 0 && slot->done < slot->len){
+            status = uring_reap(&ring, fd, slots);
+        }
+        if (status != 0){
+            break;
+        }
+        consume(ctx, slot->buffer, slot->len);
+        in_flight--;
+        if (next_offset < size){
+            slot->offset = next_offset;
+            slot->len = size - next_offset < URING_BLOCK_SIZE ? (size_t)(size - next_offset) : URING_BLOCK_SIZE;
+            slot->done = 0;
+            next_offset += (off_t)slot->len;
+            status = uring_submit_read(&ring, fd, slot, index);
+            in_flight += status == 0;
+        }
+    }
+    while (ring.pending > 0){
+        if (uring_reap(&ring, fd, NULL) != 0 && errno != EINTR){
+            break;
+        }
+    }
+    uring_teardown(&ring);
+    free(buffers);
+    close(fd);
+    return status;
+}
+#else
+static int read_io_uring(const char* path, block_consumer consume, void* ctx){
+    fprintf(stderr, "io_uring not available on this platform, using stdio\n");
+    return read_stdio(path, consume, ctx);
+}
+#endif
+
+int read_file(const char* path, input_backend backend, block_consumer consume, void* ctx){
+    switch (backend){
+    case BACKEND_MMAP:
+        return read_mmap(path, consume, ctx);
+    case BACKEND_DIRECT:
+        return read_direct(path, consume, ctx);
+    case BACKEND_IO_URING:
+        return read_io_uring(path, consume, ctx);
+    default:
+        return read_stdio(path, consume, ctx);
+    }
+}
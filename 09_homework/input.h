@@ -0,0 +1,19 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+
+typedef enum {
+    BACKEND_STDIO,
+    BACKEND_MMAP,
+    BACKEND_DIRECT,
+    BACKEND_IO_URING,
+} input_backend;
+
+typedef void (*block_consumer)(void* ctx, const unsigned char* data, size_t len);
+
+int parse_backend(const char* name, input_backend* out);
+const char* backend_name(input_backend backend);
+int read_file(const char* path, input_backend backend, block_consumer consume, void* ctx);
+
+#endif
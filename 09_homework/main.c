@@ -1,49 +1,246 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "crc32.h"
+#include "input.h"
+#include "batch.h"
+#include "checksum.h"
 
-void generate_crc_table(uint32_t *table){
-    for (uint32_t i = 0; i < 256; i++){
-        uint32_t crc = i;
-        for (uint32_t j = 0; j < 8; j++){
-            if (crc & 1){
-                crc = (crc >> 1) ^ 0xEDB88320;
-            } else {
-                crc = crc >> 1;
-            }
+#define BUFFER_SIZE (1024 * 1024 * 10)
+#define MIN_CHUNK_SIZE (4L * 1024 * 1024)
+#define CHUNKS_PER_THREAD 4
+
+typedef struct {
+    off_t offset;
+    off_t length;
+    uint32_t crc;
+    int failed;
+} crc_chunk;
+
+typedef struct {
+    int fd;
+    crc_chunk* chunks;
+    size_t count;
+    atomic_size_t next;
+} chunk_queue;
+
+static void checksum_block(void* ctx, const unsigned char* data, size_t len){
+    checksum_update((checksum_ctx*)ctx, data, len);
+}
+
+static void checksum_chunk(int fd, crc_chunk* chunk, unsigned char* buffer){
+    uint32_t crc = 0;
+    off_t done = 0;
+    while(done < chunk->length){
+        size_t wanted = chunk->length - done < BUFFER_SIZE ? (size_t)(chunk->length - done) : BUFFER_SIZE;
+        ssize_t got = pread(fd, buffer, wanted, chunk->offset + done);
+        if(got <= 0){
+            chunk->failed = 1;
+            return;
         }
-        table[i] = crc;
+        crc = crc32_update(crc, buffer, (size_t)got);
+        done += got;
     }
+    chunk->crc = crc;
 }
 
-int main(int argc, char *argv[]){
-    size_t buffer_size = 1024 * 1024 * 10;
-    if(argc != 2) {
-        printf("USAGE: %s <file>\n", argv[0]);
+static void* checksum_worker(void* arg){
+    chunk_queue* queue = (chunk_queue*)arg;
+    unsigned char* buffer = malloc(BUFFER_SIZE);
+    for(;;){
+        size_t index = atomic_fetch_add(&queue->next, 1);
+        if(index >= queue->count){
+            break;
+        }
+        if(buffer == NULL){
+            queue->chunks[index].failed = 1;
+            continue;
+        }
+        checksum_chunk(queue->fd, &queue->chunks[index], buffer);
+    }
+    free(buffer);
+    return NULL;
+}
+
+static int checksum_parallel(int fd, off_t size, size_t threads, uint32_t* out_crc){
+    off_t chunk_size = size / (off_t)(threads * CHUNKS_PER_THREAD);
+    if(chunk_size < MIN_CHUNK_SIZE){
+        chunk_size = MIN_CHUNK_SIZE;
+    }
+    chunk_queue queue;
+    queue.fd = fd;
+    queue.count = (size_t)((size + chunk_size - 1) / chunk_size);
+    queue.chunks = calloc(queue.count > 0 ? queue.count : 1, sizeof(crc_chunk));
+    if(queue.chunks == NULL){
+        return -1;
+    }
+    for(size_t i = 0; i < queue.count; i++){
+        queue.chunks[i].offset = (off_t)i * chunk_size;
+        queue.chunks[i].length = size - queue.chunks[i].offset < chunk_size ? size - queue.chunks[i].offset : chunk_size;
+    }
+    atomic_init(&queue.next, 0);
+    if(threads > queue.count){
+        threads = queue.count > 0 ? queue.count : 1;
+    }
+
+    pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+    size_t started = 0;
+    for(size_t i = 0; workers && i < threads; i++){
+        if(pthread_create(&workers[i], NULL, checksum_worker, &queue) != 0){
+            break;
+        }
+        started++;
+    }
+    if(started == 0){
+        checksum_worker(&queue);
+    }
+    for(size_t i = 0; i < started; i++){
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    uint32_t crc = 0;
+    int status = 0;
+    for(size_t i = 0; i < queue.count; i++){
+        if(queue.chunks[i].failed){
+            status = -1;
+            break;
+        }
+        crc = crc32_join(crc, queue.chunks[i].crc, (uint64_t)queue.chunks[i].length);
+    }
+    free(queue.chunks);
+    *out_crc = crc;
+    return status;
+}
+
+static int parse_threads(const char* text, size_t* out){
+    char* endptr = NULL;
+    long value = strtol(text, &endptr, 10);
+    if(endptr == text || *endptr != '\0' || value <= 0){
+        return -1;
+    }
+    *out = (size_t)value;
+    return 0;
+}
+
+static int checksum_single(const char* path, const checksum_algorithm* algo, size_t threads, input_backend backend){
+    checksum_ctx ctx;
+    checksum_init(&ctx, algo);
+    int status;
+    if(threads > 1 && strcmp(algo->name, "crc32") == 0) {
+        int fd = open(path, O_RDONLY);
+        if(fd < 0) {
+            printf("Failed to open %s for reading!\n", path);
+            return EXIT_FAILURE;
+        }
+        struct stat st;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            status = checksum_parallel(fd, st.st_size, threads, &ctx.u.crc);
+        } else {
+            status = read_file(path, backend, checksum_block, &ctx);
+        }
+        close(fd);
+    } else {
+        status = read_file(path, backend, checksum_block, &ctx);
+    }
+    if(status != 0) {
+        printf("Failed to read %s!\n", path);
         return EXIT_FAILURE;
     }
-    FILE* file = fopen(argv[1], "rb");
-    if(!file) {
-        printf("Failed to open %s for reading!\n", argv[1]);
+    printf("%s: %0*llX\n", algo->label, algo->digest_size * 2, (unsigned long long)checksum_final(&ctx));
+    return EXIT_SUCCESS;
+}
+
+static int checksum_batch(char** paths, int count, const char* manifest, const checksum_algorithm* algo, size_t threads, input_backend backend){
+    batch_list list;
+    batch_init(&list, algo);
+    int status = 0;
+    if(manifest) {
+        status = batch_load_manifest(&list, manifest);
+        if(status != 0) {
+            fprintf(stderr, "Failed to read manifest %s!\n", manifest);
+        }
+    }
+    for(int i = 0; i < count && status == 0; i++) {
+        status = batch_add_path(&list, paths[i]);
+    }
+    if(status != 0) {
+        batch_free(&list);
         return EXIT_FAILURE;
     }
-    uint32_t crc_table[256];
-    generate_crc_table(crc_table);
-    unsigned char *buffer = (unsigned char *)malloc(buffer_size);
-    if(buffer == NULL){
-        printf("Failed to allocate memory for buffer!\n");
+    if(threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    int failed = batch_run(&list, threads, backend);
+    batch_free(&list);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]){
+    char** paths = malloc(sizeof(char*) * (size_t)argc);
+    int path_count = 0;
+    const char* impl_name = NULL;
+    const char* backend_arg = NULL;
+    const char* manifest = NULL;
+    const checksum_algorithm* algo = checksum_default();
+    input_backend backend = BACKEND_STDIO;
+    size_t threads = 0;
+    int usage_error = paths == NULL;
+    for(int i = 1; i < argc && !usage_error; i++) {
+        if(strcmp(argv[i], "--impl") == 0 && i + 1 < argc) {
+            impl_name = argv[++i];
+        } else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            usage_error |= parse_threads(argv[++i], &threads) != 0;
+        } else if(strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            backend_arg = argv[++i];
+            usage_error |= parse_backend(backend_arg, &backend) != 0;
+        } else if(strcmp(argv[i], "--algo") == 0 && i + 1 < argc) {
+            algo = checksum_find(argv[++i]);
+            usage_error |= algo == NULL;
+        } else if(strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            manifest = argv[++i];
+        } else if(strncmp(argv[i], "--", 2) == 0) {
+            usage_error = 1;
+        } else {
+            paths[path_count++] = argv[i];
+        }
+    }
+    if((path_count == 0) == (manifest == NULL) || usage_error) {
+        printf("USAGE: %s [--impl pclmul|slice16|slice8|reference] [--backend stdio|mmap|direct|io_uring] [--threads N] [--algo crc32|crc32c|xxh64|xxh3] <path>...\n", argv[0]);
+        printf("       %s [options] --check <manifest>\n", argv[0]);
+        free(paths);
         return EXIT_FAILURE;
     }
-    size_t bytes_read = 0;
-    uint32_t crc = 0xFFFFFFFF;
-    while((bytes_read = fread(buffer, 1, buffer_size, file)) > 0){
-        for(size_t i = 0; i < bytes_read; i++){
-            crc = (crc >> 8) ^ crc_table[(crc ^ buffer[i]) & 0xFF];
+    crc32_init();
+    if(impl_name) {
+        const crc32_impl* impl = crc32_find_impl(impl_name);
+        if(impl == NULL || !impl->supported()) {
+            printf("Unsupported CRC32 implementation: %s\n", impl_name);
+            free(paths);
+            return EXIT_FAILURE;
         }
+        crc32_use_impl(impl);
     }
-    crc = ~crc;
-    printf("CRC32: %08X\n", crc);
-
-    free(buffer);
-    fclose(file);
+    struct stat st;
+    int result;
+    if(manifest == NULL && path_count == 1 && !(stat(paths[0], &st) == 0 && S_ISDIR(st.st_mode))) {
+        if(backend_arg && threads > 1) {
+            printf("--backend reads sequentially and cannot be combined with --threads\n");
+            result = EXIT_FAILURE;
+        } else {
+            result = checksum_single(paths[0], algo, threads, backend);
+        }
+    } else {
+        result = checksum_batch(paths, path_count, manifest, algo, threads, backend);
+    }
+    free(paths);
+    return result;
 }
@@ -0,0 +1,404 @@
+#include <string.h>
+#include "xxhash.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define XXH3_SSE2 1
+#endif
+
+#define PRIME32_1 0x9E3779B1U
+#define PRIME32_2 0x85EBCA77U
+#define PRIME32_3 0xC2B2AE3DU
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+#define PRIME_MX1 0x165667919E3779F9ULL
+#define PRIME_MX2 0x9FB21C651E98DF25ULL
+
+#define STRIPE_LEN 64
+#define SECRET_SIZE 192
+#define SECRET_CONSUME_RATE 8
+#define SECRET_LIMIT (SECRET_SIZE - STRIPE_LEN)
+#define STRIPES_PER_BLOCK (SECRET_LIMIT / SECRET_CONSUME_RATE)
+#define BUFFER_STRIPES (sizeof(((xxh3_state*)0)->buffer) / STRIPE_LEN)
+#define MIDSIZE_MAX 240
+
+static const unsigned char xxh3_secret[SECRET_SIZE] __attribute__((aligned(16))) = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint32_t read32(const unsigned char* p){
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline uint64_t read64(const unsigned char* p){
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b){
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 product = (unsigned __int128)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+    uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return lower ^ upper;
+#endif
+}
+
+static uint64_t xxh64_round(uint64_t acc, uint64_t input){
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t xxh64_merge_round(uint64_t acc, uint64_t value){
+    acc ^= xxh64_round(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static uint64_t xxh64_avalanche(uint64_t h){
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+void xxh64_init(xxh64_state* state){
+    memset(state, 0, sizeof(*state));
+    state->v[0] = PRIME64_1 + PRIME64_2;
+    state->v[1] = PRIME64_2;
+    state->v[2] = 0;
+    state->v[3] = 0 - PRIME64_1;
+}
+
+static void xxh64_consume(xxh64_state* state, const unsigned char* p){
+    state->v[0] = xxh64_round(state->v[0], read64(p));
+    state->v[1] = xxh64_round(state->v[1], read64(p + 8));
+    state->v[2] = xxh64_round(state->v[2], read64(p + 16));
+    state->v[3] = xxh64_round(state->v[3], read64(p + 24));
+}
+
+void xxh64_update(xxh64_state* state, const void* data, size_t len){
+    const unsigned char* p = data;
+    state->total_len += len;
+    if (state->mem_size + len < 32){
+        memcpy(state->mem + state->mem_size, p, len);
+        state->mem_size += len;
+        return;
+    }
+    if (state->mem_size){
+        size_t fill = 32 - state->mem_size;
+        memcpy(state->mem + state->mem_size, p, fill);
+        xxh64_consume(state, state->mem);
+        p += fill;
+        len -= fill;
+        state->mem_size = 0;
+    }
+    while (len >= 32){
+        xxh64_consume(state, p);
+        p += 32;
+        len -= 32;
+    }
+    memcpy(state->mem, p, len);
+    state->mem_size = len;
+}
+
+uint64_t xxh64_digest(const xxh64_state* state){
+    uint64_t h;
+    if (state->total_len >= 32){
+        h = rotl64(state->v[0], 1) + rotl64(state->v[1], 7) + rotl64(state->v[2], 12) + rotl64(state->v[3], 18);
+        for (int i = 0; i < 4; i++){
+            h = xxh64_merge_round(h, state->v[i]);
+        }
+    } else {
+        h = PRIME64_5;
+    }
+    h += state->total_len;
+    const unsigned char* p = state->mem;
+    size_t len = state->mem_size;
+    while (len >= 8){
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4){
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0){
+        h ^= *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+        len--;
+    }
+    return xxh64_avalanche(h);
+}
+
+static uint64_t xxh3_avalanche(uint64_t h){
+    h ^= h >> 37;
+    h *= PRIME_MX1;
+    h ^= h >> 32;
+    return h;
+}
+
+static uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len){
+    h ^= rotl64(h, 49) ^ rotl64(h, 24);
+    h *= PRIME_MX2;
+    h ^= (h >> 35) + len;
+    h *= PRIME_MX2;
+    h ^= h >> 28;
+    return h;
+}
+
+static uint64_t xxh3_mix16(const unsigned char* p, const unsigned char* secret){
+    return mul128_fold64(read64(p) ^ read64(secret), read64(p + 8) ^ read64(secret + 8));
+}
+
+static uint64_t xxh3_short(const unsigned char* p, size_t len){
+    const unsigned char* secret = xxh3_secret;
+    if (len == 0){
+        return xxh64_avalanche(read64(secret + 56) ^ read64(secret + 64));
+    }
+    if (len <= 3){
+        uint32_t combined = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] | ((uint32_t)len << 8);
+        uint64_t bitflip = read32(secret) ^ read32(secret + 4);
+        return xxh64_avalanche((uint64_t)combined ^ bitflip);
+    }
+    if (len <= 8){
+        uint64_t bitflip = read64(secret + 8) ^ read64(secret + 16);
+        uint64_t input = read32(p + len - 4) + ((uint64_t)read32(p) << 32);
+        return xxh3_rrmxmx(input ^ bitflip, len);
+    }
+    if (len <= 16){
+        uint64_t lo = read64(p) ^ (read64(secret + 24) ^ read64(secret + 32));
+        uint64_t hi = read64(p + len - 8) ^ (read64(secret + 40) ^ read64(secret + 48));
+        uint64_t acc = len + __builtin_bswap64(lo) + hi + mul128_fold64(lo, hi);
+        return xxh3_avalanche(acc);
+    }
+    uint64_t acc = len * PRIME64_1;
+    if (len <= 128){
+        if (len > 32){
+            if (len > 64){
+                if (len > 96){
+                    acc += xxh3_mix16(p + 48, secret + 96);
+                    acc += xxh3_mix16(p + len - 64, secret + 112);
+                }
+                acc += xxh3_mix16(p + 32, secret + 64);
+                acc += xxh3_mix16(p + len - 48, secret + 80);
+            }
+            acc += xxh3_mix16(p + 16, secret + 32);
+            acc += xxh3_mix16(p + len - 32, secret + 48);
+        }
+        acc += xxh3_mix16(p, secret);
+        acc += xxh3_mix16(p + len - 16, secret + 16);
+        return xxh3_avalanche(acc);
+    }
+    size_t rounds = len / 16;
+    for (size_t i = 0; i < 8; i++){
+        acc += xxh3_mix16(p + 16 * i, secret + 16 * i);
+    }
+    acc = xxh3_avalanche(acc);
+    for (size_t i = 8; i < rounds; i++){
+        acc += xxh3_mix16(p + 16 * i, secret + 16 * (i - 8) + 3);
+    }
+    acc += xxh3_mix16(p + len - 16, secret + 136 - 17);
+    return xxh3_avalanche(acc);
+}
+
+#ifdef XXH3_SSE2
+static inline __m128i xxh3_lane_sse2(__m128i acc, const unsigned char* p, const unsigned char* secret){
+    __m128i data = _mm_loadu_si128((const __m128i*)p);
+    __m128i key = _mm_loadu_si128((const __m128i*)secret);
+    __m128i data_key = _mm_xor_si128(data, key);
+    __m128i data_key_hi = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i product = _mm_mul_epu32(data_key, data_key_hi);
+    __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm_add_epi64(product, _mm_add_epi64(acc, swapped));
+}
+
+static void xxh3_accumulate(uint64_t* acc, const unsigned char* p, const unsigned char* secret, size_t stripes){
+    __m128i* xacc = (__m128i*)acc;
+    __m128i a0 = _mm_load_si128(xacc);
+    __m128i a1 = _mm_load_si128(xacc + 1);
+    __m128i a2 = _mm_load_si128(xacc + 2);
+    __m128i a3 = _mm_load_si128(xacc + 3);
+    for (size_t n = 0; n < stripes; n++){
+        const unsigned char* in = p + n * STRIPE_LEN;
+        const unsigned char* key = secret + n * SECRET_CONSUME_RATE;
+        a0 = xxh3_lane_sse2(a0, in, key);
+        a1 = xxh3_lane_sse2(a1, in + 16, key + 16);
+        a2 = xxh3_lane_sse2(a2, in + 32, key + 32);
+        a3 = xxh3_lane_sse2(a3, in + 48, key + 48);
+    }
+    _mm_store_si128(xacc, a0);
+    _mm_store_si128(xacc + 1, a1);
+    _mm_store_si128(xacc + 2, a2);
+    _mm_store_si128(xacc + 3, a3);
+}
+
+static inline void xxh3_accumulate_512(uint64_t* acc, const unsigned char* p, const unsigned char* secret){
+    xxh3_accumulate(acc, p, secret, 1);
+}
+
+static inline void xxh3_scramble(uint64_t* acc, const unsigned char* secret){
+    __m128i* xacc = (__m128i*)acc;
+    const __m128i prime = _mm_set1_epi32((int)PRIME32_1);
+    for (int i = 0; i < 4; i++){
+        __m128i value = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+        __m128i key = _mm_loadu_si128((const __m128i*)(secret + 16 * i));
+        __m128i data_key = _mm_xor_si128(value, key);
+        __m128i data_key_hi = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        __m128i product_lo = _mm_mul_epu32(data_key, prime);
+        __m128i product_hi = _mm_mul_epu32(data_key_hi, prime);
+        xacc[i] = _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32));
+    }
+}
+#else
+static inline void xxh3_accumulate_512(uint64_t* acc, const unsigned char* p, const unsigned char* secret){
+    for (int i = 0; i < 8; i++){
+        uint64_t data = read64(p + 8 * i);
+        uint64_t data_key = data ^ read64(secret + 8 * i);
+        acc[i ^ 1] += data;
+        acc[i] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+    }
+}
+
+static void xxh3_accumulate(uint64_t* acc, const unsigned char* p, const unsigned char* secret, size_t stripes){
+    uint64_t local[8];
+    memcpy(local, acc, sizeof(local));
+    for (size_t n = 0; n < stripes; n++){
+        xxh3_accumulate_512(local, p + n * STRIPE_LEN, secret + n * SECRET_CONSUME_RATE);
+    }
+    memcpy(acc, local, sizeof(local));
+}
+
+static inline void xxh3_scramble(uint64_t* acc, const unsigned char* secret){
+    for (int i = 0; i < 8; i++){
+        uint64_t value = acc[i];
+        value ^= value >> 47;
+        value ^= read64(secret + 8 * i);
+        acc[i] = value * PRIME32_1;
+    }
+}
+#endif
+
+static void xxh3_consume_stripes(uint64_t* acc, size_t* stripes_so_far, const unsigned char* p, size_t stripes){
+    if (STRIPES_PER_BLOCK - *stripes_so_far <= stripes){
+        size_t to_end = STRIPES_PER_BLOCK - *stripes_so_far;
+        size_t after = stripes - to_end;
+        xxh3_accumulate(acc, p, xxh3_secret + *stripes_so_far * SECRET_CONSUME_RATE, to_end);
+        xxh3_scramble(acc, xxh3_secret + SECRET_LIMIT);
+        xxh3_accumulate(acc, p + to_end * STRIPE_LEN, xxh3_secret, after);
+        *stripes_so_far = after;
+    } else {
+        xxh3_accumulate(acc, p, xxh3_secret + *stripes_so_far * SECRET_CONSUME_RATE, stripes);
+        *stripes_so_far += stripes;
+    }
+}
+
+static uint64_t xxh3_merge_accs(const uint64_t* acc, const unsigned char* secret, uint64_t start){
+    uint64_t result = start;
+    for (int i = 0; i < 4; i++){
+        result += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+    }
+    return xxh3_avalanche(result);
+}
+
+void xxh3_init(xxh3_state* state){
+    memset(state, 0, sizeof(*state));
+    state->acc[0] = PRIME32_3;
+    state->acc[1] = PRIME64_1;
+    state->acc[2] = PRIME64_2;
+    state->acc[3] = PRIME64_3;
+    state->acc[4] = PRIME64_4;
+    state->acc[5] = PRIME32_2;
+    state->acc[6] = PRIME64_5;
+    state->acc[7] = PRIME32_1;
+}
+
+void xxh3_update(xxh3_state* state, const void* data, size_t len){
+    const unsigned char* p = data;
+    const unsigned char* end = p + len;
+    state->total_len += len;
+    if (state->buffered + len <= sizeof(state->buffer)){
+        memcpy(state->buffer + state->buffered, p, len);
+        state->buffered += len;
+        return;
+    }
+    if (state->buffered){
+        size_t fill = sizeof(state->buffer) - state->buffered;
+        memcpy(state->buffer + state->buffered, p, fill);
+        p += fill;
+        xxh3_consume_stripes(state->acc, &state->stripes_so_far, state->buffer, BUFFER_STRIPES);
+        state->buffered = 0;
+    }
+    if ((size_t)(end - p) > sizeof(state->buffer)){
+        const unsigned char* limit = end - sizeof(state->buffer);
+        do {
+            xxh3_consume_stripes(state->acc, &state->stripes_so_far, p, BUFFER_STRIPES);
+            p += sizeof(state->buffer);
+        } while (p < limit);
+        memcpy(state->buffer + sizeof(state->buffer) - STRIPE_LEN, p - STRIPE_LEN, STRIPE_LEN);
+    }
+    memcpy(state->buffer, p, (size_t)(end - p));
+    state->buffered = (size_t)(end - p);
+}
+
+uint64_t xxh3_digest(const xxh3_state* state){
+    if (state->total_len <= MIDSIZE_MAX){
+        return xxh3_short(state->buffer, (size_t)state->total_len);
+    }
+    uint64_t acc[8] __attribute__((aligned(16)));
+    memcpy(acc, state->acc, sizeof(acc));
+    if (state->buffered >= STRIPE_LEN){
+        size_t stripes = (state->buffered - 1) / STRIPE_LEN;
+        size_t stripes_so_far = state->stripes_so_far;
+        xxh3_consume_stripes(acc, &stripes_so_far, state->buffer, stripes);
+        xxh3_accumulate_512(acc, state->buffer + state->buffered - STRIPE_LEN, xxh3_secret + SECRET_LIMIT - 7);
+    } else {
+        unsigned char last[STRIPE_LEN];
+        size_t catchup = STRIPE_LEN - state->buffered;
+        memcpy(last, state->buffer + sizeof(state->buffer) - catchup, catchup);
+        memcpy(last + catchup, state->buffer, state->buffered);
+        xxh3_accumulate_512(acc, last, xxh3_secret + SECRET_LIMIT - 7);
+    }
+    return xxh3_merge_accs(acc, xxh3_secret + 11, state->total_len * PRIME64_1);
+}
@@ -0,0 +1,30 @@
+#ifndef XXHASH_H
+#define XXHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t total_len;
+    uint64_t v[4];
+    unsigned char mem[32];
+    size_t mem_size;
+} xxh64_state;
+
+typedef struct {
+    uint64_t acc[8] __attribute__((aligned(16)));
+    unsigned char buffer[256];
+    size_t buffered;
+    size_t stripes_so_far;
+    uint64_t total_len;
+} xxh3_state;
+
+void xxh64_init(xxh64_state* state);
+void xxh64_update(xxh64_state* state, const void* data, size_t len);
+uint64_t xxh64_digest(const xxh64_state* state);
+
+void xxh3_init(xxh3_state* state);
+void xxh3_update(xxh3_state* state, const void* data, size_t len);
+uint64_t xxh3_digest(const xxh3_state* state);
+
+#endif
@@ -0,0 +1,130 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "url_decode.h"
+
+#define SAMPLE_COUNT 200000
+#define ROUNDS 10
+
+static char* legacy_url_decode(const char* encoded) {
+    if (!encoded) return NULL;
+    
+    size_t len = strlen(encoded);
+    char* decoded = malloc(len + 1);
+    if (!decoded) return NULL;
+    
+    size_t i = 0, j = 0;
+    while (i < len) {
+        if (encoded[i] == '%' && i + 2 < len) {
+            unsigned int hex_value;
+            if (sscanf(&encoded[i + 1], "%2x", &hex_value) == 1) {
+                decoded[j++] = (char)hex_value;
+                i += 3;
+            } else {
+                decoded[j++] = encoded[i++];
+            }
+        } else if (encoded[i] == '+') {
+            decoded[j++] = ' ';
+            i++;
+        } else {
+            decoded[j++] = encoded[i++];
+        }
+    }
+    decoded[j] = '\0';
+    return decoded;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* make_sample(unsigned* seed, int encoded_percent) {
+    static const char plain[] = "abcdefghijklmnopqrstuvwxyz0123456789/-_.";
+    static const char hex[] = "0123456789ABCDEF";
+    size_t len = 20 + rand_r(seed) % 100;
+    char* sample = malloc(len * 3 + 1);
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        int roll = rand_r(seed) % 100;
+        if (roll < encoded_percent) {
+            sample[j++] = '%';
+            sample[j++] = hex[rand_r(seed) % 16];
+            sample[j++] = hex[rand_r(seed) % 16];
+        } else if (roll < encoded_percent + 3) {
+            sample[j++] = '+';
+        } else {
+            sample[j++] = plain[rand_r(seed) % (sizeof(plain) - 1)];
+        }
+    }
+    sample[j] = '\0';
+    return sample;
+}
+
+static void run(const char* label, int encoded_percent) {
+    unsigned seed = 42;
+    char** samples = malloc(sizeof(char*) * SAMPLE_COUNT);
+    size_t* lengths = malloc(sizeof(size_t) * SAMPLE_COUNT);
+    size_t total = 0;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        samples[i] = make_sample(&seed, encoded_percent);
+        lengths[i] = strlen(samples[i]);
+        total += lengths[i];
+    }
+    char* out = malloc(1024);
+    char* copy = malloc(1024);
+    size_t checksum = 0;
+    
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            char* decoded = legacy_url_decode(samples[i]);
+            checksum += (unsigned char)decoded[0];
+            free(decoded);
+        }
+    }
+    double legacy = now_seconds() - start;
+    
+    start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            if (url_needs_decoding(samples[i], lengths[i])) {
+                checksum += url_decode(samples[i], lengths[i], out);
+            } else {
+                checksum += lengths[i];
+            }
+        }
+    }
+    double buffered = now_seconds() - start;
+    
+    start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            memcpy(copy, samples[i], lengths[i]);
+            checksum += url_decode_in_place(copy, lengths[i]);
+        }
+    }
+    double in_place = now_seconds() - start;
+    
+    double megabytes = (double)total * ROUNDS / (1024.0 * 1024.0);
+    printf("%-10s legacy: %8.1f MB/s  buffer: %8.1f MB/s  in-place: %8.1f MB/s  (checksum %zu)\n",
+           label, megabytes / legacy, megabytes / buffered, megabytes / in_place, checksum);
+    
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        free(samples[i]);
+    }
+    free(samples);
+    free(lengths);
+    free(out);
+    free(copy);
+}
+
+int main(void) {
+    run("plain", 0);
+    run("light", 5);
+    run("heavy", 40);
+    return 0;
+}
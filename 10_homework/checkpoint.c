@@ -0,0 +1,246 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+
+#define CHECKPOINT_RECORD_SIZE (3 * sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint64_t))
+
+static const char state_magic[8] = {'L', 'O', 'G', 'S', 'T', 'A', 'T', 'E'};
+static const uint32_t state_version = 2;
+static const char* const legacy_dimensions[] = { "url:bytes", "referer:bytes" };
+
+analyzer_state* create_state(const dimension_spec* specs, size_t count) {
+    analyzer_state* state = calloc(1, sizeof(analyzer_state));
+    if (state == NULL) {
+        return NULL;
+    }
+    state->dimension_count = count;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(state->dimension_names[i], specs[i].name, DIMENSION_NAME_MAX);
+        state->maps[i] = create_map();
+        if (state->maps[i] == NULL) {
+            free_state(state);
+            return NULL;
+        }
+    }
+    return state;
+}
+
+void free_state(analyzer_state* state) {
+    if (state == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < MAX_DIMENSIONS; i++) {
+        if (state->maps[i]) custom_map_free(state->maps[i]);
+        heavy_hitters_free(state->summaries[i]);
+    }
+    free(state->checkpoints);
+    free(state);
+}
+
+static int read_checkpoints(FILE* in, analyzer_state* state) {
+    uint64_t count;
+    struct stat st;
+    long position;
+    if (fread(&count, sizeof(count), 1, in) != 1 ||
+        (position = ftell(in)) < 0 || fstat(fileno(in), &st) != 0 ||
+        count > (uint64_t)(st.st_size - position) / CHECKPOINT_RECORD_SIZE) {
+        return -1;
+    }
+    state->checkpoints = calloc(count > 0 ? count : 1, sizeof(file_checkpoint));
+    if (state->checkpoints == NULL) {
+        return -1;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        file_checkpoint* checkpoint = &state->checkpoints[i];
+        int64_t offset;
+        if (fread(&checkpoint->dev, sizeof(checkpoint->dev), 1, in) != 1 ||
+            fread(&checkpoint->ino, sizeof(checkpoint->ino), 1, in) != 1 ||
+            fread(&offset, sizeof(offset), 1, in) != 1 ||
+            fread(&checkpoint->fingerprint_len, sizeof(checkpoint->fingerprint_len), 1, in) != 1 ||
+            fread(&checkpoint->fingerprint, sizeof(checkpoint->fingerprint), 1, in) != 1) {
+            return -1;
+        }
+        if (offset < 0 || checkpoint->fingerprint_len > FINGERPRINT_MAX_LEN) {
+            return -1;
+        }
+        checkpoint->offset = (long)offset;
+    }
+    state->checkpoint_count = count;
+    sort_checkpoints(state);
+    return 0;
+}
+
+static int read_dimensions(FILE* in, uint32_t version, analyzer_state* state) {
+    if (version == 1) {
+        state->dimension_count = sizeof(legacy_dimensions) / sizeof(legacy_dimensions[0]);
+        for (size_t i = 0; i < state->dimension_count; i++) {
+            snprintf(state->dimension_names[i], DIMENSION_NAME_MAX, "%s", legacy_dimensions[i]);
+        }
+    } else {
+        uint32_t count;
+        if (fread(&count, sizeof(count), 1, in) != 1 || count > MAX_DIMENSIONS) {
+            return -1;
+        }
+        state->dimension_count = count;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t name_len;
+            if (fread(&name_len, sizeof(name_len), 1, in) != 1 ||
+                name_len >= DIMENSION_NAME_MAX ||
+                fread(state->dimension_names[i], 1, name_len, in) != name_len) {
+                return -1;
+            }
+        }
+    }
+    for (size_t i = 0; i < state->dimension_count; i++) {
+        if ((state->maps[i] = custom_map_read(in)) == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int same_dimensions(const analyzer_state* state, const dimension_spec* specs, size_t count) {
+    if (state->dimension_count != count) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(state->dimension_names[i], specs[i].name) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+analyzer_state* load_state(const char* path, const dimension_spec* specs, size_t count) {
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) {
+        if (errno == ENOENT) {
+            return create_state(specs, count);
+        }
+        perror("fopen");
+        return NULL;
+    }
+    
+    char magic[sizeof(state_magic)];
+    uint32_t version;
+    int64_t total_bytes;
+    analyzer_state* state = calloc(1, sizeof(analyzer_state));
+    if (state == NULL ||
+        fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        memcmp(magic, state_magic, sizeof(magic)) != 0 ||
+        fread(&version, sizeof(version), 1, in) != 1 ||
+        version < 1 || version > state_version ||
+        fread(&total_bytes, sizeof(total_bytes), 1, in) != 1 ||
+        read_checkpoints(in, state) != 0 ||
+        read_dimensions(in, version, state) != 0) {
+        fprintf(stderr, "Corrupted state file: %s\n", path);
+        free_state(state);
+        fclose(in);
+        return NULL;
+    }
+    if (!same_dimensions(state, specs, count)) {
+        fprintf(stderr, "State file %s tracks different dimensions\n", path);
+        free_state(state);
+        fclose(in);
+        return NULL;
+    }
+    state->total_bytes = (long)total_bytes;
+    fclose(in);
+    return state;
+}
+
+int save_state(const analyzer_state* state, const char* path) {
+    size_t tmp_len = strlen(path) + sizeof(".tmp");
+    char* tmp_path = malloc(tmp_len);
+    if (tmp_path == NULL) {
+        return -1;
+    }
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    FILE* out = fopen(tmp_path, "wb");
+    if (out == NULL) {
+        perror("fopen");
+        free(tmp_path);
+        return -1;
+    }
+    
+    int64_t total_bytes = state->total_bytes;
+    uint64_t count = state->checkpoint_count;
+    int failed = fwrite(state_magic, 1, sizeof(state_magic), out) != sizeof(state_magic) ||
+        fwrite(&state_version, sizeof(state_version), 1, out) != 1 ||
+        fwrite(&total_bytes, sizeof(total_bytes), 1, out) != 1 ||
+        fwrite(&count, sizeof(count), 1, out) != 1;
+    for (size_t i = 0; i < state->checkpoint_count && !failed; i++) {
+        const file_checkpoint* checkpoint = &state->checkpoints[i];
+        int64_t offset = checkpoint->offset;
+        failed = fwrite(&checkpoint->dev, sizeof(checkpoint->dev), 1, out) != 1 ||
+            fwrite(&checkpoint->ino, sizeof(checkpoint->ino), 1, out) != 1 ||
+            fwrite(&offset, sizeof(offset), 1, out) != 1 ||
+            fwrite(&checkpoint->fingerprint_len, sizeof(checkpoint->fingerprint_len), 1, out) != 1 ||
+            fwrite(&checkpoint->fingerprint, sizeof(checkpoint->fingerprint), 1, out) != 1;
+    }
+    uint32_t dimension_count = (uint32_t)state->dimension_count;
+    if (!failed) {
+        failed = fwrite(&dimension_count, sizeof(dimension_count), 1, out) != 1;
+    }
+    for (size_t i = 0; i < state->dimension_count && !failed; i++) {
+        uint32_t name_len = (uint32_t)strlen(state->dimension_names[i]);
+        failed = fwrite(&name_len, sizeof(name_len), 1, out) != 1 ||
+            fwrite(state->dimension_names[i], 1, name_len, out) != name_len;
+    }
+    for (size_t i = 0; i < state->dimension_count && !failed; i++) {
+        failed = custom_map_write(state->maps[i], out) != 0;
+    }
+    if (!failed) {
+        failed = fflush(out) != 0 ||
+            fsync(fileno(out)) != 0;
+    }
+    if (fclose(out) != 0) {
+        failed = 1;
+    }
+    if (failed || rename(tmp_path, path) != 0) {
+        perror("save_state");
+        unlink(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    free(tmp_path);
+    return 0;
+}
+
+static int compare_checkpoints(const void* a, const void* b) {
+    const file_checkpoint* left = a;
+    const file_checkpoint* right = b;
+    if (left->dev != right->dev) {
+        return left->dev < right->dev ? -1 : 1;
+    }
+    if (left->ino != right->ino) {
+        return left->ino < right->ino ? -1 : 1;
+    }
+    return 0;
+}
+
+void sort_checkpoints(analyzer_state* state) {
+    qsort(state->checkpoints, state->checkpoint_count, sizeof(file_checkpoint), compare_checkpoints);
+}
+
+const file_checkpoint* find_checkpoint(const analyzer_state* state, uint64_t dev, uint64_t ino) {
+    file_checkpoint key = { .dev = dev, .ino = ino };
+    return bsearch(&key, state->checkpoints, state->checkpoint_count, sizeof(file_checkpoint), compare_checkpoints);
+}
+
+int file_fingerprint(int fd, long length, uint32_t* out_len, uint64_t* out_hash) {
+    char buffer[FINGERPRINT_MAX_LEN];
+    size_t wanted = length < FINGERPRINT_MAX_LEN ? (size_t)length : FINGERPRINT_MAX_LEN;
+    ssize_t got = pread(fd, buffer, wanted, 0);
+    if (got < 0 || (size_t)got != wanted) {
+        return -1;
+    }
+    *out_len = (uint32_t)wanted;
+    *out_hash = fnv1a64(buffer, wanted);
+    return 0;
+}
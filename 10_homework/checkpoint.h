@@ -0,0 +1,38 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "custom_map.h"
+#include "heavy_hitters.h"
+#include "dimensions.h"
+
+#define FINGERPRINT_MAX_LEN 1024
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    long offset;
+    uint32_t fingerprint_len;
+    uint64_t fingerprint;
+} file_checkpoint;
+
+typedef struct {
+    long total_bytes;
+    size_t dimension_count;
+    char dimension_names[MAX_DIMENSIONS][DIMENSION_NAME_MAX];
+    custom_map* maps[MAX_DIMENSIONS];
+    heavy_hitters* summaries[MAX_DIMENSIONS];
+    file_checkpoint* checkpoints;
+    size_t checkpoint_count;
+} analyzer_state;
+
+analyzer_state* create_state(const dimension_spec* specs, size_t count);
+void free_state(analyzer_state* state);
+analyzer_state* load_state(const char* path, const dimension_spec* specs, size_t count);
+int save_state(const analyzer_state* state, const char* path);
+void sort_checkpoints(analyzer_state* state);
+const file_checkpoint* find_checkpoint(const analyzer_state* state, uint64_t dev, uint64_t ino);
+int file_fingerprint(int fd, long length, uint32_t* out_len, uint64_t* out_hash);
+
+#endif
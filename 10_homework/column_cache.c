@@ -0,0 +1,534 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include "column_cache.h"
+#include "custom_map.h"
+#include "tokenizer.h"
+
+static const char cache_magic[8] = {'L', 'O', 'G', 'C', 'O', 'L', 'S', '\0'};
+static const uint32_t cache_version = 3;
+static const char* const column_dimensions[CACHE_COLUMN_COUNT] = { "url", "referer" };
+
+#define FINGERPRINT_SAMPLE 4096
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t ids[CACHE_COLUMN_COUNT];
+    uint64_t offsets[CACHE_COLUMN_COUNT];
+    uint64_t strings[CACHE_COLUMN_COUNT];
+    uint64_t total;
+} cache_layout;
+
+typedef struct {
+    custom_map* ids;
+    uint64_t* offsets;
+    size_t count;
+    size_t capacity;
+    char* strings;
+    size_t strings_len;
+    size_t strings_capacity;
+} dictionary_builder;
+
+typedef struct {
+    int64_t* bytes;
+    uint32_t* ids[CACHE_COLUMN_COUNT];
+    size_t count;
+    size_t capacity;
+} column_builder;
+
+static char* cache_path(const char* cache_dir, const struct stat* source, long offset) {
+    size_t dir_len = strlen(cache_dir);
+    int needs_slash = (dir_len > 0 && cache_dir[dir_len - 1] != '/');
+    size_t path_len = dir_len + 80;
+    char* path = malloc(path_len);
+    if (path == NULL) {
+        return NULL;
+    }
+    snprintf(path, path_len, "%s%s%016" PRIx64 "-%016" PRIx64 "-%016" PRIx64 ".cols", cache_dir, needs_slash ? "/" : "",
+        (uint64_t)source->st_dev, (uint64_t)source->st_ino, (uint64_t)offset);
+    return path;
+}
+
+static void compute_layout(const column_cache_header* header, cache_layout* layout) {
+    uint64_t pos = sizeof(column_cache_header);
+    layout->bytes = pos;
+    pos += header->line_count * sizeof(int64_t);
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        layout->ids[c] = pos;
+        pos += header->line_count * sizeof(uint32_t);
+    }
+    pos = (pos + 7) & ~(uint64_t)7;
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        layout->offsets[c] = pos;
+        pos += (header->dictionary_sizes[c] + 1) * sizeof(uint64_t);
+    }
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        layout->strings[c] = pos;
+        pos += header->strings_lens[c];
+    }
+    layout->total = pos;
+}
+
+static uint64_t sample_fingerprint(const char* head, size_t head_len, const char* tail, size_t tail_len) {
+    return fnv1a64(head, head_len) ^ (fnv1a64(tail, tail_len) * 0x9e3779b97f4a7c15ULL);
+}
+
+static void sample_bounds(uint64_t offset, uint64_t end, uint64_t* head_start, size_t* head_len, uint64_t* tail_start, size_t* tail_len) {
+    *head_start = offset > 0 ? offset - 1 : 0;
+    *head_len = end - *head_start < FINGERPRINT_SAMPLE ? (size_t)(end - *head_start) : FINGERPRINT_SAMPLE;
+    *tail_len = *head_len;
+    *tail_start = end - *tail_len;
+}
+
+static uint64_t mapped_fingerprint(const char* data, uint64_t offset, uint64_t end) {
+    uint64_t head_start, tail_start;
+    size_t head_len, tail_len;
+    sample_bounds(offset, end, &head_start, &head_len, &tail_start, &tail_len);
+    return sample_fingerprint(data + head_start, head_len, data + tail_start, tail_len);
+}
+
+static int file_fingerprint_range(int fd, uint64_t offset, uint64_t end, uint64_t* out) {
+    char head[FINGERPRINT_SAMPLE];
+    char tail[FINGERPRINT_SAMPLE];
+    uint64_t head_start, tail_start;
+    size_t head_len, tail_len;
+    sample_bounds(offset, end, &head_start, &head_len, &tail_start, &tail_len);
+    if (pread(fd, head, head_len, (off_t)head_start) != (ssize_t)head_len ||
+        pread(fd, tail, tail_len, (off_t)tail_start) != (ssize_t)tail_len) {
+        return -1;
+    }
+    *out = sample_fingerprint(head, head_len, tail, tail_len);
+    return 0;
+}
+
+static int matches_source(const column_cache_header* header, int fd, const struct stat* source, long offset, long limit) {
+    if (memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header->version != cache_version ||
+        header->column_count != CACHE_COLUMN_COUNT ||
+        header->source_dev != (uint64_t)source->st_dev ||
+        header->source_ino != (uint64_t)source->st_ino ||
+        header->source_offset != (uint64_t)offset ||
+        header->source_limit != (uint64_t)limit) {
+        return 0;
+    }
+    if (header->source_end >= header->source_size) {
+        return header->source_size == (uint64_t)source->st_size &&
+            header->source_mtime_sec == (int64_t)source->st_mtim.tv_sec &&
+            header->source_mtime_nsec == (int64_t)source->st_mtim.tv_nsec;
+    }
+    uint64_t fingerprint;
+    return header->source_end <= (uint64_t)source->st_size &&
+        file_fingerprint_range(fd, header->source_offset, header->source_end, &fingerprint) == 0 &&
+        fingerprint == header->source_fingerprint;
+}
+
+static int valid_dictionary(const cache_dictionary* dictionary, uint64_t strings_len) {
+    if (dictionary->offsets[0] != 0 || dictionary->offsets[dictionary->count] != strings_len) {
+        return 0;
+    }
+    for (uint64_t i = 0; i < dictionary->count; i++) {
+        uint64_t end = dictionary->offsets[i + 1];
+        if (end <= dictionary->offsets[i] || dictionary->strings[end - 1] != '\0') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int column_cache_open(const char* cache_dir, const char* log_path, long offset, long limit, column_cache* cache) {
+    int source_fd = open(log_path, O_RDONLY);
+    if (source_fd < 0) {
+        return -1;
+    }
+    struct stat source;
+    char* path = fstat(source_fd, &source) == 0 ? cache_path(cache_dir, &source, offset) : NULL;
+    if (path == NULL) {
+        close(source_fd);
+        return -1;
+    }
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) {
+        close(source_fd);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(column_cache_header)) {
+        close(fd);
+        close(source_fd);
+        return -1;
+    }
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        close(source_fd);
+        return -1;
+    }
+
+    const column_cache_header* header = mapping;
+    uint64_t size = (uint64_t)st.st_size;
+    int valid = matches_source(header, source_fd, &source, offset, limit) && header->line_count <= size;
+    close(source_fd);
+    for (int c = 0; c < CACHE_COLUMN_COUNT && valid; c++) {
+        valid = header->dictionary_sizes[c] <= size && header->strings_lens[c] <= size;
+    }
+    cache_layout layout;
+    if (valid) {
+        compute_layout(header, &layout);
+        valid = layout.total == size;
+    }
+    if (!valid) {
+        munmap(mapping, (size_t)st.st_size);
+        return -1;
+    }
+
+    const char* base = mapping;
+    cache->mapping = mapping;
+    cache->mapping_size = (size_t)st.st_size;
+    cache->line_count = header->line_count;
+    cache->bytes = (const int64_t*)(base + layout.bytes);
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        cache->ids[c] = (const uint32_t*)(base + layout.ids[c]);
+        cache->dictionaries[c].count = header->dictionary_sizes[c];
+        cache->dictionaries[c].offsets = (const uint64_t*)(base + layout.offsets[c]);
+        cache->dictionaries[c].strings = base + layout.strings[c];
+        if (!valid_dictionary(&cache->dictionaries[c], header->strings_lens[c])) {
+            column_cache_close(cache);
+            return -1;
+        }
+    }
+    madvise(mapping, cache->mapping_size, MADV_SEQUENTIAL);
+    return 0;
+}
+
+void column_cache_close(column_cache* cache) {
+    if (cache->mapping) {
+        munmap(cache->mapping, cache->mapping_size);
+        cache->mapping = NULL;
+    }
+}
+
+static int intern(dictionary_builder* builder, const char* key, size_t key_len, uint32_t* out_id) {
+    long id = custom_map_get(builder->ids, key, key_len);
+    if (id > 0) {
+        *out_id = (uint32_t)(id - 1);
+        return 0;
+    }
+    if (builder->count == UINT32_MAX) {
+        return -1;
+    }
+    if (builder->count + 2 > builder->capacity) {
+        size_t capacity = builder->capacity * 2;
+        uint64_t* offsets = realloc(builder->offsets, sizeof(uint64_t) * capacity);
+        if (offsets == NULL) {
+            return -1;
+        }
+        builder->offsets = offsets;
+        builder->capacity = capacity;
+    }
+    if (builder->strings_len + key_len + 1 > builder->strings_capacity) {
+        size_t capacity = (builder->strings_len + key_len + 1) * 2;
+        char* strings = realloc(builder->strings, capacity);
+        if (strings == NULL) {
+            return -1;
+        }
+        builder->strings = strings;
+        builder->strings_capacity = capacity;
+    }
+    memcpy(builder->strings + builder->strings_len, key, key_len);
+    builder->strings[builder->strings_len + key_len] = '\0';
+    builder->strings_len += key_len + 1;
+    builder->offsets[builder->count + 1] = builder->strings_len;
+    if (custom_map_add_or_insert(builder->ids, key, key_len, (long)builder->count + 1) != 0) {
+        return -1;
+    }
+    *out_id = (uint32_t)builder->count++;
+    return 0;
+}
+
+static int append_line(column_builder* columns, int64_t bytes, const uint32_t* ids) {
+    if (columns->count == columns->capacity) {
+        size_t capacity = columns->capacity * 2;
+        int64_t* column = realloc(columns->bytes, sizeof(int64_t) * capacity);
+        if (column == NULL) {
+            return -1;
+        }
+        columns->bytes = column;
+        for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+            uint32_t* id_column = realloc(columns->ids[c], sizeof(uint32_t) * capacity);
+            if (id_column == NULL) {
+                return -1;
+            }
+            columns->ids[c] = id_column;
+        }
+        columns->capacity = capacity;
+    }
+    columns->bytes[columns->count] = bytes;
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        columns->ids[c][columns->count] = ids[c];
+    }
+    columns->count++;
+    return 0;
+}
+
+static int encode_lines(const char* cursor, const char* stop, const char* end,
+                        dictionary_builder* dictionaries, column_builder* columns, const char** consumed) {
+    const dimension* dims[CACHE_COLUMN_COUNT];
+    field_scratch scratch[CACHE_COLUMN_COUNT];
+    memset(scratch, 0, sizeof(scratch));
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        dims[c] = find_dimension(column_dimensions[c], strlen(column_dimensions[c]));
+    }
+
+    int status = 0;
+    while (cursor < stop && status == 0) {
+        const char* newline = memchr(cursor, '\n', end - cursor);
+        const char* line_end = newline ? newline : end;
+        log_fields fields;
+        if (tokenize_line(cursor, line_end - cursor, 0, &fields) == 0) {
+            uint32_t ids[CACHE_COLUMN_COUNT];
+            for (int c = 0; c < CACHE_COLUMN_COUNT && status == 0; c++) {
+                const char* key;
+                size_t key_len;
+                status = dims[c]->extract(&fields, &scratch[c], &key, &key_len) != 0 ||
+                    intern(&dictionaries[c], key, key_len, &ids[c]) != 0 ? -1 : 0;
+            }
+            if (status == 0) {
+                status = append_line(columns, fields.bytes, ids);
+            }
+        }
+        cursor = newline ? newline + 1 : end;
+    }
+    *consumed = cursor;
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        free_scratch(&scratch[c]);
+    }
+    return status;
+}
+
+static int write_cache(const char* path, const column_cache_header* header,
+                       const dictionary_builder* dictionaries, const column_builder* columns) {
+    size_t tmp_len = strlen(path) + sizeof(".tmp");
+    char* tmp_path = malloc(tmp_len);
+    if (tmp_path == NULL) {
+        return -1;
+    }
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    FILE* out = fopen(tmp_path, "wb");
+    if (out == NULL) {
+        perror("fopen");
+        free(tmp_path);
+        return -1;
+    }
+
+    static const char padding[8] = {0};
+    size_t ids_size = columns->count * sizeof(uint32_t) * CACHE_COLUMN_COUNT;
+    int failed = fwrite(header, sizeof(*header), 1, out) != 1 ||
+        fwrite(columns->bytes, sizeof(int64_t), columns->count, out) != columns->count;
+    for (int c = 0; c < CACHE_COLUMN_COUNT && !failed; c++) {
+        failed = fwrite(columns->ids[c], sizeof(uint32_t), columns->count, out) != columns->count;
+    }
+    if (!failed && ids_size % 8 != 0) {
+        failed = fwrite(padding, 1, 8 - ids_size % 8, out) != 8 - ids_size % 8;
+    }
+    for (int c = 0; c < CACHE_COLUMN_COUNT && !failed; c++) {
+        size_t count = dictionaries[c].count + 1;
+        failed = fwrite(dictionaries[c].offsets, sizeof(uint64_t), count, out) != count;
+    }
+    for (int c = 0; c < CACHE_COLUMN_COUNT && !failed; c++) {
+        size_t len = dictionaries[c].strings_len;
+        failed = len > 0 && fwrite(dictionaries[c].strings, 1, len, out) != len;
+    }
+    if (fclose(out) != 0) {
+        failed = 1;
+    }
+    if (failed || rename(tmp_path, path) != 0) {
+        perror("column_cache_build");
+        unlink(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    free(tmp_path);
+    return 0;
+}
+
+int column_cache_build(const char* cache_dir, const char* log_path, long offset, long limit, column_cache* cache) {
+    if (mkdir(cache_dir, 0755) != 0 && errno != EEXIST) {
+        perror("mkdir");
+        return -1;
+    }
+    int fd = open(log_path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    struct stat source;
+    if (fstat(fd, &source) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (limit > source.st_size) {
+        limit = source.st_size;
+    }
+    long page_size = sysconf(_SC_PAGESIZE);
+    long map_start = offset > 0 ? (offset - 1) / page_size * page_size : 0;
+    size_t size = map_start < source.st_size ? (size_t)(source.st_size - map_start) : 0;
+    char* mapping = NULL;
+    if (size > 0) {
+        mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, map_start);
+        if (mapping == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            return -1;
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    dictionary_builder dictionaries[CACHE_COLUMN_COUNT];
+    column_builder columns = { malloc(sizeof(int64_t) * 1024), { NULL }, 0, 1024 };
+    int status = columns.bytes == NULL ? -1 : 0;
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        dictionaries[c] = (dictionary_builder){ create_map(), calloc(1024, sizeof(uint64_t)), 0, 1024, NULL, 0, 0 };
+        columns.ids[c] = malloc(sizeof(uint32_t) * 1024);
+        if (dictionaries[c].ids == NULL || dictionaries[c].offsets == NULL || columns.ids[c] == NULL) {
+            status = -1;
+        }
+    }
+    uint64_t source_end = (uint64_t)offset;
+    uint64_t fingerprint = 0;
+    if (status == 0 && mapping != NULL && offset < limit) {
+        const char* data = mapping - map_start;
+        const char* end = data + source.st_size;
+        const char* cursor = data + offset;
+        if (offset > 0) {
+            const char* newline = memchr(cursor - 1, '\n', end - cursor + 1);
+            cursor = newline ? newline + 1 : end;
+        }
+        const char* consumed = cursor;
+        status = encode_lines(cursor, data + limit, end, dictionaries, &columns, &consumed);
+        source_end = (uint64_t)(consumed - data);
+        fingerprint = mapped_fingerprint(data, (uint64_t)offset, source_end);
+    }
+    if (mapping) {
+        munmap(mapping, size);
+    }
+
+    char* path = status == 0 ? cache_path(cache_dir, &source, offset) : NULL;
+    if (path != NULL) {
+        column_cache_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, cache_magic, sizeof(cache_magic));
+        header.version = cache_version;
+        header.column_count = CACHE_COLUMN_COUNT;
+        header.source_dev = (uint64_t)source.st_dev;
+        header.source_ino = (uint64_t)source.st_ino;
+        header.source_offset = (uint64_t)offset;
+        header.source_limit = (uint64_t)limit;
+        header.source_end = source_end;
+        header.source_fingerprint = fingerprint;
+        header.source_size = (uint64_t)source.st_size;
+        header.source_mtime_sec = (int64_t)source.st_mtim.tv_sec;
+        header.source_mtime_nsec = (int64_t)source.st_mtim.tv_nsec;
+        header.line_count = columns.count;
+        for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+            header.dictionary_sizes[c] = dictionaries[c].count;
+            header.strings_lens[c] = dictionaries[c].strings_len;
+        }
+        status = write_cache(path, &header, dictionaries, &columns);
+        free(path);
+    } else {
+        status = -1;
+    }
+
+    for (int c = 0; c < CACHE_COLUMN_COUNT; c++) {
+        if (dictionaries[c].ids) custom_map_free(dictionaries[c].ids);
+        free(dictionaries[c].offsets);
+        free(dictionaries[c].strings);
+        free(columns.ids[c]);
+    }
+    free(columns.bytes);
+    if (status != 0) {
+        return -1;
+    }
+    return column_cache_open(cache_dir, log_path, offset, limit, cache);
+}
+
+long column_cache_total_bytes(const column_cache* cache) {
+    long total = 0;
+    for (uint64_t i = 0; i < cache->line_count; i++) {
+        total += cache->bytes[i];
+    }
+    return total;
+}
+
+long* column_cache_totals(const column_cache* cache, cache_column column, dimension_metric metric) {
+    const cache_dictionary* dictionary = &cache->dictionaries[column];
+    long* totals = calloc(dictionary->count > 0 ? dictionary->count : 1, sizeof(long));
+    if (totals == NULL) {
+        return NULL;
+    }
+    const uint32_t* ids = cache->ids[column];
+    if (metric == METRIC_BYTES) {
+        for (uint64_t i = 0; i < cache->line_count; i++) {
+            if (ids[i] < dictionary->count) totals[ids[i]] += cache->bytes[i];
+        }
+    } else {
+        for (uint64_t i = 0; i < cache->line_count; i++) {
+            if (ids[i] < dictionary->count) totals[ids[i]]++;
+        }
+    }
+    return totals;
+}
+
+static int compare_sources(const void* a, const void* b) {
+    const cache_source* left = a;
+    const cache_source* right = b;
+    if (left->dev != right->dev) {
+        return left->dev < right->dev ? -1 : 1;
+    }
+    if (left->ino != right->ino) {
+        return left->ino < right->ino ? -1 : 1;
+    }
+    return 0;
+}
+
+int column_cache_prune(const char* cache_dir, const cache_source* live, size_t count) {
+    cache_source* sorted = malloc(sizeof(cache_source) * (count > 0 ? count : 1));
+    if (sorted == NULL) {
+        return -1;
+    }
+    memcpy(sorted, live, sizeof(cache_source) * count);
+    qsort(sorted, count, sizeof(cache_source), compare_sources);
+    DIR* dir = opendir(cache_dir);
+    if (dir == NULL) {
+        free(sorted);
+        return -1;
+    }
+    int dir_fd = dirfd(dir);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        cache_source key;
+        uint64_t offset;
+        int consumed = 0;
+        if (sscanf(entry->d_name, "%16" SCNx64 "-%16" SCNx64 "-%16" SCNx64 ".cols%n",
+                   &key.dev, &key.ino, &offset, &consumed) != 3 || consumed == 0 || entry->d_name[consumed] != '\0') {
+            continue;
+        }
+        const cache_source* source = bsearch(&key, sorted, count, sizeof(cache_source), compare_sources);
+        if (source == NULL || offset >= source->size) {
+            unlinkat(dir_fd, entry->d_name, 0);
+        }
+    }
+    closedir(dir);
+    free(sorted);
+    return 0;
+}
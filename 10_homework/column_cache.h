@@ -0,0 +1,56 @@
+#ifndef COLUMN_CACHE_H
+#define COLUMN_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dimensions.h"
+
+#define COLUMN_CACHE_SEGMENT_SIZE (64L * 1024 * 1024)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t source_dev;
+    uint64_t source_ino;
+    uint64_t source_offset;
+    uint64_t source_limit;
+    uint64_t source_end;
+    uint64_t source_fingerprint;
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint64_t line_count;
+    uint64_t dictionary_sizes[CACHE_COLUMN_COUNT];
+    uint64_t strings_lens[CACHE_COLUMN_COUNT];
+} column_cache_header;
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+} cache_source;
+
+typedef struct {
+    uint64_t count;
+    const uint64_t* offsets;
+    const char* strings;
+} cache_dictionary;
+
+typedef struct {
+    void* mapping;
+    size_t mapping_size;
+    uint64_t line_count;
+    const int64_t* bytes;
+    const uint32_t* ids[CACHE_COLUMN_COUNT];
+    cache_dictionary dictionaries[CACHE_COLUMN_COUNT];
+} column_cache;
+
+int column_cache_open(const char* cache_dir, const char* log_path, long offset, long limit, column_cache* cache);
+int column_cache_build(const char* cache_dir, const char* log_path, long offset, long limit, column_cache* cache);
+void column_cache_close(column_cache* cache);
+int column_cache_prune(const char* cache_dir, const cache_source* live, size_t count);
+long column_cache_total_bytes(const column_cache* cache);
+long* column_cache_totals(const column_cache* cache, cache_column column, dimension_metric metric);
+
+#endif
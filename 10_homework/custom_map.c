@@ -0,0 +1,299 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "custom_map.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define MAX_KEY_LEN (16 * 1024 * 1024)
+#define MIN_RECORD_SIZE (sizeof(uint32_t) + sizeof(int64_t))
+
+uint64_t fnv1a64(const char* s, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static const char* arena_store(arena* a, const char* data, size_t len) {
+    size_t needed = len + 1;
+    arena_block* block = a->head;
+    if (block == NULL || block->capacity - block->used < needed) {
+        size_t capacity = needed > ARENA_BLOCK_SIZE ? needed : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(arena_block) + capacity);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->next = a->head;
+        block->used = 0;
+        block->capacity = capacity;
+        a->head = block;
+    }
+    char* stored = block->data + block->used;
+    memcpy(stored, data, len);
+    stored[len] = '\0';
+    block->used += needed;
+    return stored;
+}
+
+static void arena_free(arena* a) {
+    arena_block* block = a->head;
+    while (block) {
+        arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    a->head = NULL;
+}
+
+static custom_map* create_map_with_capacity(size_t capacity) {
+    custom_map* map = malloc(sizeof(custom_map));
+    if (map == NULL) {
+        return NULL;
+    }
+    map->slots = calloc(capacity, sizeof(map_slot));
+    if (map->slots == NULL) {
+        free(map);
+        return NULL;
+    }
+    map->capacity = capacity;
+    map->size = 0;
+    map->load_factor_threshold = capacity * 3 / 4;
+    map->keys.head = NULL;
+    map->probes = 0;
+    map->resizes = 0;
+    return map;
+}
+
+custom_map* create_map(void) {
+    return create_map_with_capacity(1024);
+}
+
+void custom_map_free(custom_map* map) {
+    arena_free(&map->keys);
+    free(map->slots);
+    free(map);
+}
+
+static void place_slot(map_slot* slots, size_t capacity, map_slot entry) {
+    size_t mask = capacity - 1;
+    size_t index = entry.hash & mask;
+    entry.distance = 1;
+    for (;;) {
+        map_slot* slot = &slots[index];
+        if (slot->distance == 0) {
+            *slot = entry;
+            return;
+        }
+        if (slot->distance < entry.distance) {
+            map_slot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+        }
+        index = (index + 1) & mask;
+        entry.distance++;
+    }
+}
+
+static int resize_map(custom_map* map, size_t new_capacity) {
+    size_t old_capacity = map->capacity;
+    map_slot* old_slots = map->slots;
+    map_slot* new_slots = calloc(new_capacity, sizeof(map_slot));
+    if (new_slots == NULL) {
+        return -1;
+    }
+    
+    map->slots = new_slots;
+    map->capacity = new_capacity;
+    map->resizes++;
+    map->load_factor_threshold = map->capacity * 3 / 4;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].distance != 0) {
+            place_slot(map->slots, map->capacity, old_slots[i]);
+        }
+    }
+    
+    free(old_slots);
+    return 0;
+}
+
+int custom_map_reserve(custom_map* map, size_t expected_size) {
+    size_t capacity = map->capacity;
+    while (capacity * 3 / 4 <= expected_size) {
+        if (capacity > SIZE_MAX / 2 / sizeof(map_slot)) {
+            return -1;
+        }
+        capacity *= 2;
+    }
+    if (capacity != map->capacity) {
+        return resize_map(map, capacity);
+    }
+    return 0;
+}
+
+static int upsert(custom_map* map, uint64_t hash, const char* key, size_t key_len, long delta, int copy_key) {
+    if (map->size >= map->load_factor_threshold && resize_map(map, map->capacity * 2) != 0) {
+        return -1;
+    }
+    size_t mask = map->capacity - 1;
+    size_t index = hash & mask;
+    uint32_t distance = 1;
+    for (;;) {
+        map_slot* slot = &map->slots[index];
+        if (slot->distance == 0 || slot->distance < distance) {
+            break;
+        }
+        if (slot->hash == hash && slot->key_len == key_len && memcmp(slot->key, key, key_len) == 0) {
+            slot->value += delta;
+            map->probes += distance;
+            return 0;
+        }
+        index = (index + 1) & mask;
+        distance++;
+    }
+    map->probes += distance;
+    
+    const char* stored = copy_key ? arena_store(&map->keys, key, key_len) : key;
+    if (stored == NULL) {
+        return -1;
+    }
+    map_slot entry = {
+        .hash = hash,
+        .key = stored,
+        .key_len = (uint32_t)key_len,
+        .value = delta,
+    };
+    place_slot(map->slots, map->capacity, entry);
+    map->size++;
+    return 0;
+}
+
+int custom_map_add_hashed(custom_map* map, uint64_t hash, const char* key, size_t key_len, long delta) {
+    return upsert(map, hash, key, key_len, delta, 1);
+}
+
+int custom_map_merge(custom_map* dst, custom_map* src) {
+    int status = custom_map_reserve(dst, dst->size + src->size);
+    for (size_t i = 0; i < src->capacity && status == 0; i++) {
+        map_slot* slot = &src->slots[i];
+        if (slot->distance != 0) {
+            status = upsert(dst, slot->hash, slot->key, slot->key_len, slot->value, 0);
+        }
+    }
+    
+    arena_block* block = src->keys.head;
+    while (block) {
+        arena_block* next = block->next;
+        block->next = dst->keys.head;
+        dst->keys.head = block;
+        block = next;
+    }
+    src->keys.head = NULL;
+    return status;
+}
+
+int custom_map_add_or_insert(custom_map* map, const char* key, size_t key_len, long delta) {
+    return custom_map_add_hashed(map, fnv1a64(key, key_len), key, key_len, delta);
+}
+
+long custom_map_get(const custom_map* map, const char* key, size_t key_len) {
+    uint64_t hash = fnv1a64(key, key_len);
+    size_t mask = map->capacity - 1;
+    size_t index = hash & mask;
+    uint32_t distance = 1;
+    for (;;) {
+        const map_slot* slot = &map->slots[index];
+        if (slot->distance == 0 || slot->distance < distance) {
+            return 0;
+        }
+        if (slot->hash == hash && slot->key_len == key_len && memcmp(slot->key, key, key_len) == 0) {
+            return slot->value;
+        }
+        index = (index + 1) & mask;
+        distance++;
+    }
+}
+
+int custom_map_write(const custom_map* map, FILE* out) {
+    uint64_t count = map->size;
+    if (fwrite(&count, sizeof(count), 1, out) != 1) {
+        return -1;
+    }
+    for (size_t i = 0; i < map->capacity; i++) {
+        const map_slot* slot = &map->slots[i];
+        if (slot->distance == 0) {
+            continue;
+        }
+        int64_t value = slot->value;
+        if (fwrite(&slot->key_len, sizeof(slot->key_len), 1, out) != 1 ||
+            fwrite(&value, sizeof(value), 1, out) != 1 ||
+            fwrite(slot->key, 1, slot->key_len, out) != slot->key_len) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static long bytes_remaining(FILE* in) {
+    struct stat st;
+    long position = ftell(in);
+    if (position < 0 || fstat(fileno(in), &st) != 0 || st.st_size < position) {
+        return -1;
+    }
+    return (long)st.st_size - position;
+}
+
+custom_map* custom_map_read(FILE* in) {
+    uint64_t count;
+    if (fread(&count, sizeof(count), 1, in) != 1) {
+        return NULL;
+    }
+    long remaining = bytes_remaining(in);
+    if (remaining < 0 || count > (uint64_t)remaining / MIN_RECORD_SIZE) {
+        return NULL;
+    }
+    custom_map* map = create_map();
+    if (map == NULL) {
+        return NULL;
+    }
+    int ok = custom_map_reserve(map, count) == 0;
+    char* key = NULL;
+    size_t key_capacity = 0;
+    for (uint64_t i = 0; i < count && ok; i++) {
+        uint32_t key_len;
+        int64_t value;
+        if (fread(&key_len, sizeof(key_len), 1, in) != 1 || fread(&value, sizeof(value), 1, in) != 1) {
+            ok = 0;
+            break;
+        }
+        if (key_len > MAX_KEY_LEN) {
+            ok = 0;
+            break;
+        }
+        if ((size_t)key_len + 1 > key_capacity) {
+            char* grown = realloc(key, (size_t)key_len + 1);
+            if (grown == NULL) {
+                ok = 0;
+                break;
+            }
+            key = grown;
+            key_capacity = (size_t)key_len + 1;
+        }
+        if (fread(key, 1, key_len, in) != key_len) {
+            ok = 0;
+            break;
+        }
+        if (custom_map_add_or_insert(map, key, key_len, value) != 0) {
+            ok = 0;
+        }
+    }
+    free(key);
+    if (!ok) {
+        custom_map_free(map);
+        return NULL;
+    }
+    return map;
+}
@@ -0,0 +1,49 @@
+#ifndef CUSTOM_MAP_H
+#define CUSTOM_MAP_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct arena_block {
+    struct arena_block* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} arena_block;
+
+typedef struct {
+    arena_block* head;
+} arena;
+
+typedef struct {
+    uint64_t hash;
+    const char* key;
+    uint32_t key_len;
+    uint32_t distance;
+    long value;
+} map_slot;
+
+typedef struct {
+    map_slot* slots;
+    size_t capacity;
+    size_t size;
+    size_t load_factor_threshold;
+    arena keys;
+    size_t probes;
+    size_t resizes;
+} custom_map;
+
+uint64_t fnv1a64(const char* s, size_t len);
+
+custom_map* create_map(void);
+void custom_map_free(custom_map* map);
+int custom_map_add_or_insert(custom_map* map, const char* key, size_t key_len, long delta);
+int custom_map_add_hashed(custom_map* map, uint64_t hash, const char* key, size_t key_len, long delta);
+int custom_map_reserve(custom_map* map, size_t expected_size);
+int custom_map_merge(custom_map* dst, custom_map* src);
+long custom_map_get(const custom_map* map, const char* key, size_t key_len);
+int custom_map_write(const custom_map* map, FILE* out);
+custom_map* custom_map_read(FILE* in);
+
+#endif
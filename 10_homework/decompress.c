@@ -0,0 +1,386 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "decompress.h"
+
+#define BLOCK_SIZE (1024 * 1024)
+#define INPUT_SIZE (256 * 1024)
+
+log_compression detect_compression(int fd) {
+    unsigned char magic[4];
+    ssize_t got = pread(fd, magic, sizeof(magic), 0);
+    if (got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return LOG_GZIP;
+    }
+    if (got == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return LOG_ZSTD;
+    }
+    return LOG_PLAIN;
+}
+
+int compression_supported(log_compression compression) {
+#ifdef HAVE_ZSTD
+    (void)compression;
+    return 1;
+#else
+    return compression != LOG_ZSTD;
+#endif
+}
+
+static int ring_init(block_ring* ring, size_t capacity) {
+    ring->slots = malloc(sizeof(data_block*) * capacity);
+    if (ring->slots == NULL) {
+        return -1;
+    }
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->count = 0;
+    ring->closed = 0;
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->not_empty, NULL);
+    pthread_cond_init(&ring->not_full, NULL);
+    return 0;
+}
+
+static void ring_destroy(block_ring* ring) {
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->not_empty);
+    pthread_cond_destroy(&ring->not_full);
+    free(ring->slots);
+}
+
+static void ring_push(block_ring* ring, data_block* block) {
+    pthread_mutex_lock(&ring->lock);
+    while (ring->count == ring->capacity) {
+        pthread_cond_wait(&ring->not_full, &ring->lock);
+    }
+    ring->slots[(ring->head + ring->count) % ring->capacity] = block;
+    ring->count++;
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static data_block* ring_take(block_ring* ring) {
+    data_block* block = ring->slots[ring->head];
+    ring->head = (ring->head + 1) % ring->capacity;
+    ring->count--;
+    pthread_cond_signal(&ring->not_full);
+    return block;
+}
+
+static data_block* ring_pop(block_ring* ring, int wait) {
+    pthread_mutex_lock(&ring->lock);
+    while (wait && ring->count == 0 && !ring->closed) {
+        pthread_cond_wait(&ring->not_empty, &ring->lock);
+    }
+    data_block* block = ring->count > 0 ? ring_take(ring) : NULL;
+    pthread_mutex_unlock(&ring->lock);
+    return block;
+}
+
+static void ring_close(block_ring* ring) {
+    pthread_mutex_lock(&ring->lock);
+    ring->closed = 1;
+    pthread_cond_broadcast(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+typedef struct {
+    decompress_pipeline* pipeline;
+    data_block* block;
+} block_writer;
+
+static int reserve_block(block_writer* writer, size_t needed) {
+    if (writer->block == NULL) {
+        writer->block = ring_pop(&writer->pipeline->free_blocks, 1);
+        if (writer->block == NULL) {
+            return -1;
+        }
+        writer->block->len = 0;
+    }
+    data_block* block = writer->block;
+    if (block->capacity - block->len >= needed) {
+        return 0;
+    }
+    size_t capacity = block->capacity > BLOCK_SIZE ? block->capacity : BLOCK_SIZE;
+    while (capacity - block->len < needed) {
+        capacity *= 2;
+    }
+    char* grown = realloc(block->data, capacity);
+    if (grown == NULL) {
+        return -1;
+    }
+    block->data = grown;
+    block->capacity = capacity;
+    return 0;
+}
+
+static int flush_lines(block_writer* writer, int final) {
+    data_block* block = writer->block;
+    if (block == NULL || block->len == 0) {
+        return 0;
+    }
+    char* newline = final ? block->data + block->len - 1 : memrchr(block->data, '\n', block->len);
+    if (newline == NULL) {
+        return 0;
+    }
+    size_t complete = newline - block->data + 1;
+    data_block* next = NULL;
+    if (complete < block->len) {
+        next = ring_pop(&writer->pipeline->free_blocks, 1);
+        if (next == NULL) {
+            return -1;
+        }
+        size_t rest = block->len - complete;
+        if (next->capacity < rest) {
+            char* grown = realloc(next->data, rest * 2);
+            if (grown == NULL) {
+                ring_push(&writer->pipeline->free_blocks, next);
+                return -1;
+            }
+            next->data = grown;
+            next->capacity = rest * 2;
+        }
+        memcpy(next->data, block->data + complete, rest);
+        next->len = rest;
+        block->len = complete;
+    }
+    ring_push(&writer->pipeline->filled, block);
+    writer->block = next;
+    return 0;
+}
+
+static int inflate_gzip(FILE* file, block_writer* writer) {
+    unsigned char* input = malloc(INPUT_SIZE);
+    if (input == NULL) {
+        return -1;
+    }
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        free(input);
+        return -1;
+    }
+    int status = Z_OK;
+    int output_full = 0;
+    int result = 0;
+    while (result == 0) {
+        if (stream.avail_in == 0 && !output_full) {
+            stream.avail_in = (uInt)fread(input, 1, INPUT_SIZE, file);
+            stream.next_in = input;
+            if (stream.avail_in == 0) {
+                if (status != Z_STREAM_END || ferror(file)) {
+                    result = -1;
+                }
+                break;
+            }
+        }
+        if (status == Z_STREAM_END) {
+            inflateReset(&stream);
+        }
+        if (reserve_block(writer, 1) != 0) {
+            result = -1;
+            break;
+        }
+        data_block* block = writer->block;
+        stream.next_out = (unsigned char*)block->data + block->len;
+        stream.avail_out = (uInt)(block->capacity - block->len);
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+            result = -1;
+            break;
+        }
+        block->len = block->capacity - stream.avail_out;
+        output_full = stream.avail_out == 0 && status != Z_STREAM_END;
+        if (block->len == block->capacity && flush_lines(writer, 0) != 0) {
+            result = -1;
+        }
+    }
+    inflateEnd(&stream);
+    free(input);
+    return result;
+}
+
+#ifdef HAVE_ZSTD
+static int inflate_zstd(FILE* file, block_writer* writer) {
+    unsigned char* input = malloc(INPUT_SIZE);
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    if (input == NULL || stream == NULL) {
+        free(input);
+        ZSTD_freeDStream(stream);
+        return -1;
+    }
+    ZSTD_initDStream(stream);
+    ZSTD_inBuffer in = { input, 0, 0 };
+    size_t status = 1;
+    int output_full = 0;
+    int result = 0;
+    while (result == 0) {
+        if (in.pos == in.size && !output_full) {
+            in.size = fread(input, 1, INPUT_SIZE, file);
+            in.pos = 0;
+            if (in.size == 0) {
+                if (status != 0 || ferror(file)) {
+                    result = -1;
+                }
+                break;
+            }
+        }
+        if (reserve_block(writer, 1) != 0) {
+            result = -1;
+            break;
+        }
+        data_block* block = writer->block;
+        ZSTD_outBuffer out = { block->data, block->capacity, block->len };
+        status = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(status)) {
+            result = -1;
+            break;
+        }
+        block->len = out.pos;
+        output_full = out.pos == out.size && status != 0;
+        if (block->len == block->capacity && flush_lines(writer, 0) != 0) {
+            result = -1;
+        }
+    }
+    ZSTD_freeDStream(stream);
+    free(input);
+    return result;
+}
+#endif
+
+static void decompress_file(decompress_pipeline* pipeline, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror("fopen");
+        atomic_store(&pipeline->failed, 1);
+        return;
+    }
+    block_writer writer = { pipeline, NULL };
+    int result = -1;
+    switch (detect_compression(fileno(file))) {
+    case LOG_GZIP:
+        result = inflate_gzip(file, &writer);
+        break;
+    case LOG_ZSTD:
+#ifdef HAVE_ZSTD
+        result = inflate_zstd(file, &writer);
+#endif
+        break;
+    case LOG_PLAIN:
+        break;
+    }
+    if (writer.block != NULL) {
+        if (writer.block->len == 0) {
+            ring_push(&pipeline->free_blocks, writer.block);
+        } else if (flush_lines(&writer, 1) != 0) {
+            result = -1;
+        }
+    }
+    if (result != 0) {
+        fprintf(stderr, "Failed to decompress %s\n", path);
+        atomic_store(&pipeline->failed, 1);
+    }
+    fclose(file);
+}
+
+static void* decompress_func(void* arg) {
+    decompress_pipeline* pipeline = (decompress_pipeline*)arg;
+    size_t index;
+    while ((index = atomic_fetch_add(&pipeline->next, 1)) < pipeline->count) {
+        decompress_file(pipeline, pipeline->paths[index]);
+    }
+    if (atomic_fetch_sub(&pipeline->running, 1) == 1) {
+        ring_close(&pipeline->filled);
+    }
+    return NULL;
+}
+
+int pipeline_start(decompress_pipeline* pipeline, const char** paths, size_t count, size_t decompressors, size_t block_count) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->paths = paths;
+    pipeline->count = count;
+    atomic_init(&pipeline->next, 0);
+    atomic_init(&pipeline->failed, 0);
+    if (count == 0) {
+        return 0;
+    }
+    if (decompressors > count) {
+        decompressors = count;
+    }
+    if (block_count < decompressors * 2) {
+        block_count = decompressors * 2;
+    }
+    pipeline->blocks = calloc(block_count, sizeof(data_block));
+    pipeline->workers = malloc(sizeof(pthread_t) * decompressors);
+    if (pipeline->blocks == NULL || pipeline->workers == NULL ||
+        ring_init(&pipeline->filled, block_count) != 0) {
+        free(pipeline->blocks);
+        free(pipeline->workers);
+        return -1;
+    }
+    if (ring_init(&pipeline->free_blocks, block_count) != 0) {
+        ring_destroy(&pipeline->filled);
+        free(pipeline->blocks);
+        free(pipeline->workers);
+        return -1;
+    }
+    pipeline->block_count = block_count;
+    for (size_t i = 0; i < block_count; i++) {
+        pipeline->blocks[i].data = malloc(BLOCK_SIZE);
+        pipeline->blocks[i].capacity = pipeline->blocks[i].data ? BLOCK_SIZE : 0;
+        ring_push(&pipeline->free_blocks, &pipeline->blocks[i]);
+    }
+    atomic_init(&pipeline->running, decompressors);
+    for (size_t i = 0; i < decompressors; i++) {
+        if (pthread_create(&pipeline->workers[i], NULL, decompress_func, pipeline) != 0) {
+            if (atomic_fetch_sub(&pipeline->running, decompressors - i) == decompressors - i) {
+                ring_close(&pipeline->filled);
+            }
+            break;
+        }
+        pipeline->worker_count++;
+    }
+    return 0;
+}
+
+data_block* pipeline_try_next(decompress_pipeline* pipeline) {
+    if (pipeline->count == 0) {
+        return NULL;
+    }
+    return ring_pop(&pipeline->filled, 0);
+}
+
+data_block* pipeline_next(decompress_pipeline* pipeline) {
+    if (pipeline->count == 0) {
+        return NULL;
+    }
+    return ring_pop(&pipeline->filled, 1);
+}
+
+void pipeline_release(decompress_pipeline* pipeline, data_block* block) {
+    ring_push(&pipeline->free_blocks, block);
+}
+
+int pipeline_finish(decompress_pipeline* pipeline) {
+    if (pipeline->count == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < pipeline->worker_count; i++) {
+        pthread_join(pipeline->workers[i], NULL);
+    }
+    for (size_t i = 0; i < pipeline->block_count; i++) {
+        free(pipeline->blocks[i].data);
+    }
+    ring_destroy(&pipeline->filled);
+    ring_destroy(&pipeline->free_blocks);
+    free(pipeline->blocks);
+    free(pipeline->workers);
+    return atomic_load(&pipeline->failed) ? -1 : 0;
+}
@@ -0,0 +1,54 @@
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef enum {
+    LOG_PLAIN,
+    LOG_GZIP,
+    LOG_ZSTD,
+} log_compression;
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} data_block;
+
+typedef struct {
+    data_block** slots;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    int closed;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} block_ring;
+
+typedef struct {
+    const char** paths;
+    size_t count;
+    atomic_size_t next;
+    atomic_size_t running;
+    atomic_int failed;
+    block_ring filled;
+    block_ring free_blocks;
+    data_block* blocks;
+    size_t block_count;
+    pthread_t* workers;
+    size_t worker_count;
+} decompress_pipeline;
+
+log_compression detect_compression(int fd);
+int compression_supported(log_compression compression);
+
+int pipeline_start(decompress_pipeline* pipeline, const char** paths, size_t count, size_t decompressors, size_t block_count);
+data_block* pipeline_try_next(decompress_pipeline* pipeline);
+data_block* pipeline_next(decompress_pipeline* pipeline);
+void pipeline_release(decompress_pipeline* pipeline, data_block* block);
+int pipeline_finish(decompress_pipeline* pipeline);
+
+#endif
@@ -0,0 +1,241 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dimensions.h"
+#include "url_decode.h"
+
+#define MINUTE_KEY_LEN 17
+
+static const char* const month_names[12] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+};
+
+static int reserve_scratch(field_scratch* scratch, size_t len) {
+    if (len <= scratch->capacity) {
+        return 0;
+    }
+    size_t capacity = len * 2;
+    char* buf = realloc(scratch->buf, capacity);
+    if (buf == NULL) {
+        return -1;
+    }
+    scratch->buf = buf;
+    scratch->capacity = capacity;
+    return 0;
+}
+
+static int decode_field(field_scratch* scratch, const char* field, size_t len, const char** key, size_t* key_len) {
+    if (scratch->in_place) {
+        *key_len = url_decode_in_place((char*)field, len);
+        *key = field;
+        return 0;
+    }
+    if (!url_needs_decoding(field, len)) {
+        *key_len = len;
+        *key = field;
+        return 0;
+    }
+    if (reserve_scratch(scratch, len) != 0) {
+        return -1;
+    }
+    *key_len = url_decode(field, len, scratch->buf);
+    *key = scratch->buf;
+    return 0;
+}
+
+static int placeholder(const char* field, size_t len, const char* text, const char** key, size_t* key_len) {
+    if (field != NULL && len > 0 && !(len == 1 && field[0] == '-')) {
+        return 0;
+    }
+    *key = text;
+    *key_len = strlen(text);
+    return 1;
+}
+
+static int extract_url(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len) {
+    return decode_field(scratch, fields->url, fields->url_len, key, key_len);
+}
+
+static int extract_referer(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len) {
+    if (placeholder(fields->referer, fields->referer_len, "(no referer)", key, key_len)) {
+        return 0;
+    }
+    return decode_field(scratch, fields->referer, fields->referer_len, key, key_len);
+}
+
+static int extract_ip(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len) {
+    (void)scratch;
+    if (fields->ip == NULL || fields->ip_len == 0) {
+        return -1;
+    }
+    *key = fields->ip;
+    *key_len = fields->ip_len;
+    return 0;
+}
+
+static int extract_status(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len) {
+    (void)scratch;
+    if (fields->status == NULL || fields->status_len == 0) {
+        return -1;
+    }
+    *key = fields->status;
+    *key_len = fields->status_len;
+    return 0;
+}
+
+static int extract_user_agent(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len) {
+    (void)scratch;
+    if (!placeholder(fields->user_agent, fields->user_agent_len, "(no user agent)", key, key_len)) {
+        *key = fields->user_agent;
+        *key_len = fields->user_agent_len;
+    }
+    return 0;
+}
+
+static int parse_digits(const char* text, size_t count, int* out) {
+    int value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    *out = value;
+    return 0;
+}
+
+static long days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long year_of_era = year - era * 400;
+    long day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+static int extract_minute(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len) {
+    const char* from = fields->ip ? fields->ip + fields->ip_len : fields->line;
+    const char* stamp = memchr(from, '[', (size_t)(fields->url - from));
+    if (stamp == NULL || (size_t)(fields->url - stamp) < sizeof("[10/Oct/2000:13:55:36 -0700]") - 1) {
+        return -1;
+    }
+    stamp++;
+    int day, year, hour, minute, zone_hours, zone_minutes;
+    int month = -1;
+    for (int i = 0; i < 12; i++) {
+        if (memcmp(stamp + 3, month_names[i], 3) == 0) {
+            month = i + 1;
+            break;
+        }
+    }
+    if (month < 0 ||
+        parse_digits(stamp, 2, &day) != 0 ||
+        parse_digits(stamp + 7, 4, &year) != 0 ||
+        parse_digits(stamp + 12, 2, &hour) != 0 ||
+        parse_digits(stamp + 15, 2, &minute) != 0 ||
+        (stamp[21] != '+' && stamp[21] != '-') ||
+        parse_digits(stamp + 22, 2, &zone_hours) != 0 ||
+        parse_digits(stamp + 24, 2, &zone_minutes) != 0) {
+        return -1;
+    }
+    long offset = (zone_hours * 60L + zone_minutes) * 60;
+    time_t seconds = (time_t)(days_from_civil(year, month, day) * 86400 + hour * 3600L + minute * 60L);
+    seconds -= stamp[21] == '+' ? offset : -offset;
+    struct tm utc;
+    if (gmtime_r(&seconds, &utc) == NULL || reserve_scratch(scratch, MINUTE_KEY_LEN + 1) != 0) {
+        return -1;
+    }
+    *key_len = strftime(scratch->buf, scratch->capacity, "%Y-%m-%dT%H:%MZ", &utc);
+    *key = scratch->buf;
+    return *key_len > 0 ? 0 : -1;
+}
+
+static const dimension dimensions[] = {
+    { "url", "URL", METRIC_BYTES, 0, 0, CACHE_COLUMN_URL, extract_url },
+    { "referer", "Referer", METRIC_BYTES, 0, 0, CACHE_COLUMN_REFERER, extract_referer },
+    { "ip", "IP", METRIC_BYTES, 0, 0, CACHE_COLUMN_NONE, extract_ip },
+    { "status", "Status", METRIC_REQUESTS, 0, 0, CACHE_COLUMN_NONE, extract_status },
+    { "ua", "User agent", METRIC_REQUESTS, 0, TOKENIZE_USER_AGENT, CACHE_COLUMN_NONE, extract_user_agent },
+    { "minute", "Minute", METRIC_REQUESTS, 1, 0, CACHE_COLUMN_NONE, extract_minute },
+};
+
+const dimension* find_dimension(const char* name, size_t len) {
+    for (size_t i = 0; i < sizeof(dimensions) / sizeof(dimensions[0]); i++) {
+        if (strlen(dimensions[i].name) == len && memcmp(dimensions[i].name, name, len) == 0) {
+            return &dimensions[i];
+        }
+    }
+    return NULL;
+}
+
+int parse_dimensions(const char* text, dimension_spec* specs, size_t* out_count) {
+    size_t count = 0;
+    const char* cursor = text;
+    for (;;) {
+        const char* end = strchr(cursor, ',');
+        size_t len = end ? (size_t)(end - cursor) : strlen(cursor);
+        const char* colon = memchr(cursor, ':', len);
+        size_t name_len = colon ? (size_t)(colon - cursor) : len;
+        const dimension* dim = find_dimension(cursor, name_len);
+        if (dim == NULL) {
+            fprintf(stderr, "Unknown dimension: %.*s\n", (int)name_len, cursor);
+            return -1;
+        }
+        dimension_metric metric = dim->default_metric;
+        if (colon) {
+            size_t metric_len = len - name_len - 1;
+            if (metric_len == 5 && memcmp(colon + 1, "bytes", 5) == 0) {
+                metric = METRIC_BYTES;
+            } else if (metric_len == 8 && memcmp(colon + 1, "requests", 8) == 0) {
+                metric = METRIC_REQUESTS;
+            } else {
+                fprintf(stderr, "Unknown metric: %.*s\n", (int)metric_len, colon + 1);
+                return -1;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (specs[i].dim == dim) {
+                fprintf(stderr, "Duplicate dimension: %s\n", dim->name);
+                return -1;
+            }
+        }
+        if (count == MAX_DIMENSIONS) {
+            fprintf(stderr, "Too many dimensions (max %d)\n", MAX_DIMENSIONS);
+            return -1;
+        }
+        specs[count].dim = dim;
+        specs[count].metric = metric;
+        snprintf(specs[count].name, sizeof(specs[count].name), "%s:%s", dim->name, metric_unit(metric));
+        count++;
+        if (end == NULL) {
+            break;
+        }
+        cursor = end + 1;
+    }
+    *out_count = count;
+    return 0;
+}
+
+int dimensions_tokenize_flags(const dimension_spec* specs, size_t count) {
+    int flags = 0;
+    for (size_t i = 0; i < count; i++) {
+        flags |= specs[i].dim->tokenize_flags;
+    }
+    return flags;
+}
+
+long metric_value(dimension_metric metric, const log_fields* fields) {
+    return metric == METRIC_BYTES ? fields->bytes : 1;
+}
+
+const char* metric_unit(dimension_metric metric) {
+    return metric == METRIC_BYTES ? "bytes" : "requests";
+}
+
+void free_scratch(field_scratch* scratch) {
+    free(scratch->buf);
+    scratch->buf = NULL;
+    scratch->capacity = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef DIMENSIONS_H
+#define DIMENSIONS_H
+
+#include <stddef.h>
+#include "tokenizer.h"
+
+#define MAX_DIMENSIONS 8
+#define DIMENSION_NAME_MAX 32
+#define DEFAULT_DIMENSIONS "url,referer"
+
+typedef enum {
+    METRIC_BYTES,
+    METRIC_REQUESTS,
+} dimension_metric;
+
+typedef enum {
+    CACHE_COLUMN_NONE = -1,
+    CACHE_COLUMN_URL,
+    CACHE_COLUMN_REFERER,
+    CACHE_COLUMN_COUNT,
+} cache_column;
+
+typedef struct {
+    char* buf;
+    size_t capacity;
+    int in_place;
+} field_scratch;
+
+typedef int (*key_extractor)(const log_fields* fields, field_scratch* scratch, const char** key, size_t* key_len);
+
+typedef struct {
+    const char* name;
+    const char* label;
+    dimension_metric default_metric;
+    int chronological;
+    int tokenize_flags;
+    cache_column column;
+    key_extractor extract;
+} dimension;
+
+typedef struct {
+    const dimension* dim;
+    dimension_metric metric;
+    char name[DIMENSION_NAME_MAX];
+} dimension_spec;
+
+const dimension* find_dimension(const char* name, size_t len);
+int parse_dimensions(const char* text, dimension_spec* specs, size_t* out_count);
+int dimensions_tokenize_flags(const dimension_spec* specs, size_t count);
+long metric_value(dimension_metric metric, const log_fields* fields);
+const char* metric_unit(dimension_metric metric);
+void free_scratch(field_scratch* scratch);
+
+#endif
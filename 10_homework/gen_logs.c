@@ -0,0 +1,216 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define DEFAULT_SIZE_MB 64
+#define DEFAULT_FILES 1
+#define DEFAULT_URLS 10000
+#define DEFAULT_REFERERS 500
+#define DEFAULT_SKEW 1.1
+#define START_TIME 1577836800
+
+typedef struct {
+    double* cdf;
+    size_t count;
+} zipf_table;
+
+typedef struct {
+    long size_mb;
+    long files;
+    long urls;
+    long referers;
+    double skew;
+    unsigned long seed;
+    const char* output_dir;
+} generator_config;
+
+static const char* const user_agents[] = {
+    "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36",
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:121.0) Gecko/20100101 Firefox/121.0",
+    "Mozilla/5.0 (iPhone; CPU iPhone OS 17_2 like Mac OS X) AppleWebKit/605.1.15 Mobile/15E148",
+    "curl/8.5.0",
+    "Googlebot/2.1 (+http://www.google.com/bot.html)",
+    "-",
+};
+
+static const int statuses[] = { 200, 200, 200, 200, 200, 200, 200, 304, 404, 500 };
+
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static double next_unit(uint64_t* state) {
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int zipf_init(zipf_table* table, size_t count, double skew) {
+    table->cdf = malloc(sizeof(double) * count);
+    if (table->cdf == NULL) {
+        return -1;
+    }
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += 1.0 / pow((double)(i + 1), skew);
+        table->cdf[i] = sum;
+    }
+    for (size_t i = 0; i < count; i++) {
+        table->cdf[i] /= sum;
+    }
+    table->count = count;
+    return 0;
+}
+
+static size_t zipf_sample(const zipf_table* table, uint64_t* state) {
+    double target = next_unit(state);
+    size_t low = 0;
+    size_t high = table->count - 1;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (table->cdf[mid] < target) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static int write_url(char* out, size_t size, size_t rank) {
+    switch (rank % 8) {
+    case 0:
+        return snprintf(out, size, "/search?q=term%%20%zu", rank);
+    case 1:
+        return snprintf(out, size, "/static/img/%zu.png", rank);
+    case 2:
+        return snprintf(out, size, "/api/v1/items/%zu", rank);
+    default:
+        return snprintf(out, size, "/p/%zu", rank);
+    }
+}
+
+static int write_referer(char* out, size_t size, size_t rank) {
+    if (rank == 0) {
+        return snprintf(out, size, "-");
+    }
+    if (rank % 5 == 0) {
+        return snprintf(out, size, "https://www.google.com/search?q=page%%20%zu", rank);
+    }
+    return snprintf(out, size, "https://site%zu.example.com/", rank);
+}
+
+static int generate_file(const generator_config* config, const zipf_table* urls, const zipf_table* referers, long index) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/access-%03ld.log", config->output_dir, index);
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        perror("fopen");
+        return -1;
+    }
+    uint64_t state = config->seed * 1000003ULL + (uint64_t)index;
+    long target = config->size_mb * 1024 * 1024 / config->files;
+    long written = 0;
+    time_t timestamp = START_TIME + index * 86400;
+    char url[64];
+    char referer[96];
+    char stamp[32];
+    while (written < target) {
+        timestamp += (time_t)(next_random(&state) % 3);
+        struct tm tm;
+        gmtime_r(&timestamp, &tm);
+        strftime(stamp, sizeof(stamp), "%d/%b/%Y:%H:%M:%S +0000", &tm);
+        write_url(url, sizeof(url), zipf_sample(urls, &state));
+        write_referer(referer, sizeof(referer), zipf_sample(referers, &state));
+        uint64_t ip = next_random(&state);
+        int status = statuses[next_random(&state) % (sizeof(statuses) / sizeof(statuses[0]))];
+        long bytes = status == 304 ? 0 : 200 + (long)(next_random(&state) % 100000);
+        const char* agent = user_agents[next_random(&state) % (sizeof(user_agents) / sizeof(user_agents[0]))];
+        int len = fprintf(out, "10.%u.%u.%u - - [%s] \"GET %s HTTP/1.1\" %d %ld \"%s\" \"%s\"\n",
+            (unsigned)(ip & 0xff), (unsigned)((ip >> 8) & 0xff), (unsigned)((ip >> 16) & 0xff),
+            stamp, url, status, bytes, referer, agent);
+        if (len < 0) {
+            perror("fprintf");
+            fclose(out);
+            return -1;
+        }
+        written += len;
+    }
+    if (fclose(out) != 0) {
+        perror("fclose");
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_long(const char* text, long* out) {
+    char* endptr = NULL;
+    long value = strtol(text, &endptr, 10);
+    if (endptr == text || *endptr != '\0' || value <= 0) {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    generator_config config = { DEFAULT_SIZE_MB, DEFAULT_FILES, DEFAULT_URLS, DEFAULT_REFERERS, DEFAULT_SKEW, 1, NULL };
+    for (int i = 1; i < argc; i++) {
+        long seed;
+        int ok = 1;
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            ok = parse_long(argv[++i], &config.size_mb) == 0;
+        } else if (strcmp(argv[i], "--files") == 0 && i + 1 < argc) {
+            ok = parse_long(argv[++i], &config.files) == 0;
+        } else if (strcmp(argv[i], "--urls") == 0 && i + 1 < argc) {
+            ok = parse_long(argv[++i], &config.urls) == 0;
+        } else if (strcmp(argv[i], "--referers") == 0 && i + 1 < argc) {
+            ok = parse_long(argv[++i], &config.referers) == 0;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            ok = parse_long(argv[++i], &seed) == 0;
+            config.seed = (unsigned long)seed;
+        } else if (strcmp(argv[i], "--skew") == 0 && i + 1 < argc) {
+            char* endptr = NULL;
+            config.skew = strtod(argv[++i], &endptr);
+            ok = *endptr == '\0' && config.skew >= 0;
+        } else if (config.output_dir == NULL && argv[i][0] != '-') {
+            config.output_dir = argv[i];
+        } else {
+            ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr, "Invalid argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (config.output_dir == NULL) {
+        fprintf(stderr, "Usage: %s [--size MB] [--files N] [--urls N] [--referers N] [--skew S] [--seed N] <output_dir>\n", argv[0]);
+        return 1;
+    }
+    if (mkdir(config.output_dir, 0755) != 0 && errno != EEXIST) {
+        perror("mkdir");
+        return 1;
+    }
+
+    zipf_table urls;
+    zipf_table referers;
+    if (zipf_init(&urls, (size_t)config.urls, config.skew) != 0 ||
+        zipf_init(&referers, (size_t)config.referers, config.skew) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    int status = 0;
+    for (long i = 0; i < config.files && status == 0; i++) {
+        status = generate_file(&config, &urls, &referers, i);
+    }
+    free(urls.cdf);
+    free(referers.cdf);
+    return status == 0 ? 0 : 1;
+}
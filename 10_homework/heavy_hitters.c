@@ -0,0 +1,282 @@
+#include <stdlib.h>
+#include <string.h>
+#include "heavy_hitters.h"
+#include "custom_map.h"
+
+#define HH_EXPECTED_KEY_LEN 64
+#define HH_EMPTY 0
+
+size_t heavy_hitters_capacity_for(size_t budget_bytes) {
+    size_t per_counter = sizeof(hh_counter) + sizeof(size_t) + 2 * sizeof(uint32_t) + HH_EXPECTED_KEY_LEN;
+    return budget_bytes / per_counter;
+}
+
+heavy_hitters* heavy_hitters_create(size_t capacity) {
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    heavy_hitters* hh = calloc(1, sizeof(heavy_hitters));
+    if (hh == NULL) {
+        return NULL;
+    }
+    hh->index_capacity = 1;
+    while (hh->index_capacity < capacity * 2) {
+        hh->index_capacity *= 2;
+    }
+    hh->capacity = capacity;
+    hh->counters = calloc(capacity, sizeof(hh_counter));
+    hh->heap = malloc(sizeof(size_t) * capacity);
+    hh->index = calloc(hh->index_capacity, sizeof(uint32_t));
+    if (hh->counters == NULL || hh->heap == NULL || hh->index == NULL) {
+        heavy_hitters_free(hh);
+        return NULL;
+    }
+    return hh;
+}
+
+void heavy_hitters_free(heavy_hitters* hh) {
+    if (hh == NULL) {
+        return;
+    }
+    if (hh->counters) {
+        for (size_t i = 0; i < hh->size; i++) {
+            free(hh->counters[i].key);
+        }
+    }
+    free(hh->counters);
+    free(hh->heap);
+    free(hh->index);
+    free(hh);
+}
+
+static size_t find_slot(const heavy_hitters* hh, uint64_t hash, const char* key, size_t key_len) {
+    size_t mask = hh->index_capacity - 1;
+    size_t slot = hash & mask;
+    while (hh->index[slot] != HH_EMPTY) {
+        const hh_counter* counter = &hh->counters[hh->index[slot] - 1];
+        if (counter->hash == hash && counter->key_len == key_len && memcmp(counter->key, key, key_len) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void index_remove(heavy_hitters* hh, size_t slot) {
+    size_t mask = hh->index_capacity - 1;
+    hh->index[slot] = HH_EMPTY;
+    size_t next = (slot + 1) & mask;
+    while (hh->index[next] != HH_EMPTY) {
+        size_t home = hh->counters[hh->index[next] - 1].hash & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            hh->index[slot] = hh->index[next];
+            hh->index[next] = HH_EMPTY;
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+}
+
+static void heap_swap(heavy_hitters* hh, size_t a, size_t b) {
+    size_t tmp = hh->heap[a];
+    hh->heap[a] = hh->heap[b];
+    hh->heap[b] = tmp;
+    hh->counters[hh->heap[a]].heap_index = a;
+    hh->counters[hh->heap[b]].heap_index = b;
+}
+
+static void heap_sift_down(heavy_hitters* hh, size_t index) {
+    for (;;) {
+        size_t smallest = index;
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+        if (left < hh->size && hh->counters[hh->heap[left]].count < hh->counters[hh->heap[smallest]].count) smallest = left;
+        if (right < hh->size && hh->counters[hh->heap[right]].count < hh->counters[hh->heap[smallest]].count) smallest = right;
+        if (smallest == index) return;
+        heap_swap(hh, index, smallest);
+        index = smallest;
+    }
+}
+
+static void heap_sift_up(heavy_hitters* hh, size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (hh->counters[hh->heap[parent]].count <= hh->counters[hh->heap[index]].count) return;
+        heap_swap(hh, index, parent);
+        index = parent;
+    }
+}
+
+static int store_key(hh_counter* counter, const char* key, size_t key_len) {
+    if (key_len + 1 > counter->key_capacity) {
+        char* grown = realloc(counter->key, key_len + 1);
+        if (grown == NULL) {
+            return -1;
+        }
+        counter->key = grown;
+        counter->key_capacity = (uint32_t)(key_len + 1);
+    }
+    memcpy(counter->key, key, key_len);
+    counter->key[key_len] = '\0';
+    counter->key_len = (uint32_t)key_len;
+    return 0;
+}
+
+static void insert_counter(heavy_hitters* hh, size_t slot, uint64_t hash, const char* key, size_t key_len, long count, long error) {
+    size_t position;
+    if (hh->size < hh->capacity) {
+        position = hh->size;
+        hh_counter* counter = &hh->counters[position];
+        if (store_key(counter, key, key_len) != 0) {
+            return;
+        }
+        counter->hash = hash;
+        counter->count = count;
+        counter->error = error;
+        counter->heap_index = hh->size;
+        hh->heap[hh->size++] = position;
+        hh->index[slot] = (uint32_t)(position + 1);
+        heap_sift_up(hh, counter->heap_index);
+        return;
+    }
+    
+    position = hh->heap[0];
+    hh_counter* victim = &hh->counters[position];
+    index_remove(hh, find_slot(hh, victim->hash, victim->key, victim->key_len));
+    long floor = victim->count;
+    if (store_key(victim, key, key_len) != 0) {
+        return;
+    }
+    victim->hash = hash;
+    victim->error = floor + error;
+    victim->count = floor + count;
+    hh->index[find_slot(hh, hash, key, key_len)] = (uint32_t)(position + 1);
+    heap_sift_down(hh, 0);
+}
+
+void heavy_hitters_add(heavy_hitters* hh, const char* key, size_t key_len, long weight) {
+    uint64_t hash = fnv1a64(key, key_len);
+    size_t slot = find_slot(hh, hash, key, key_len);
+    hh->total += weight;
+    if (hh->index[slot] != HH_EMPTY) {
+        hh_counter* counter = &hh->counters[hh->index[slot] - 1];
+        counter->count += weight;
+        heap_sift_down(hh, counter->heap_index);
+        return;
+    }
+    insert_counter(hh, slot, hash, key, key_len, weight, 0);
+}
+
+static long min_count(const heavy_hitters* hh) {
+    return hh->size == hh->capacity ? hh->counters[hh->heap[0]].count : 0;
+}
+
+typedef struct {
+    const hh_counter* source;
+    long count;
+    long error;
+} merge_candidate;
+
+static int compare_candidates(const void* a, const void* b) {
+    const merge_candidate* left = a;
+    const merge_candidate* right = b;
+    if (left->count != right->count) {
+        return left->count < right->count ? 1 : -1;
+    }
+    return 0;
+}
+
+int heavy_hitters_merge(heavy_hitters* dst, const heavy_hitters* src) {
+    long dst_floor = heavy_hitters_error_bound(dst);
+    long src_floor = heavy_hitters_error_bound(src);
+    merge_candidate* candidates = malloc(sizeof(merge_candidate) * (dst->size + src->size + 1));
+    if (candidates == NULL) {
+        return -1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < dst->size; i++) {
+        const hh_counter* counter = &dst->counters[i];
+        size_t slot = find_slot(src, counter->hash, counter->key, counter->key_len);
+        merge_candidate* candidate = &candidates[count++];
+        candidate->source = counter;
+        if (src->index[slot] != HH_EMPTY) {
+            const hh_counter* other = &src->counters[src->index[slot] - 1];
+            candidate->count = counter->count + other->count;
+            candidate->error = counter->error + other->error;
+        } else {
+            candidate->count = counter->count + src_floor;
+            candidate->error = counter->error + src_floor;
+        }
+    }
+    for (size_t i = 0; i < src->size; i++) {
+        const hh_counter* counter = &src->counters[i];
+        size_t slot = find_slot(dst, counter->hash, counter->key, counter->key_len);
+        if (dst->index[slot] != HH_EMPTY) {
+            continue;
+        }
+        merge_candidate* candidate = &candidates[count++];
+        candidate->source = counter;
+        candidate->count = counter->count + dst_floor;
+        candidate->error = counter->error + dst_floor;
+    }
+    qsort(candidates, count, sizeof(merge_candidate), compare_candidates);
+    if (count > dst->capacity) {
+        count = dst->capacity;
+    }
+    
+    heavy_hitters* merged = heavy_hitters_create(dst->capacity);
+    if (merged == NULL) {
+        free(candidates);
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const hh_counter* source = candidates[i].source;
+        size_t slot = find_slot(merged, source->hash, source->key, source->key_len);
+        insert_counter(merged, slot, source->hash, source->key, source->key_len, candidates[i].count, candidates[i].error);
+    }
+    merged->total = dst->total + src->total;
+    merged->absent_bound = dst_floor + src_floor;
+    free(candidates);
+    
+    heavy_hitters old = *dst;
+    *dst = *merged;
+    *merged = old;
+    heavy_hitters_free(merged);
+    return 0;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const hh_entry* left = a;
+    const hh_entry* right = b;
+    if (left->count != right->count) {
+        return left->count < right->count ? 1 : -1;
+    }
+    size_t min_len = left->key_len < right->key_len ? left->key_len : right->key_len;
+    int cmp = memcmp(left->key, right->key, min_len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return left->key_len < right->key_len ? -1 : (left->key_len > right->key_len);
+}
+
+hh_entry* heavy_hitters_top(const heavy_hitters* hh, size_t k, size_t* out_count) {
+    hh_entry* entries = malloc(sizeof(hh_entry) * (hh->size > 0 ? hh->size : 1));
+    if (entries == NULL) {
+        *out_count = 0;
+        return NULL;
+    }
+    for (size_t i = 0; i < hh->size; i++) {
+        entries[i].key = hh->counters[i].key;
+        entries[i].key_len = hh->counters[i].key_len;
+        entries[i].count = hh->counters[i].count;
+        entries[i].error = hh->counters[i].error;
+    }
+    qsort(entries, hh->size, sizeof(hh_entry), compare_entries);
+    *out_count = hh->size < k ? hh->size : k;
+    return entries;
+}
+
+long heavy_hitters_error_bound(const heavy_hitters* hh) {
+    long floor = min_count(hh);
+    return floor > hh->absent_bound ? floor : hh->absent_bound;
+}
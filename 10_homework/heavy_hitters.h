@@ -0,0 +1,43 @@
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    char* key;
+    uint32_t key_len;
+    uint32_t key_capacity;
+    uint64_t hash;
+    long count;
+    long error;
+    size_t heap_index;
+} hh_counter;
+
+typedef struct {
+    hh_counter* counters;
+    size_t capacity;
+    size_t size;
+    size_t* heap;
+    uint32_t* index;
+    size_t index_capacity;
+    long total;
+    long absent_bound;
+} heavy_hitters;
+
+typedef struct {
+    const char* key;
+    size_t key_len;
+    long count;
+    long error;
+} hh_entry;
+
+size_t heavy_hitters_capacity_for(size_t budget_bytes);
+heavy_hitters* heavy_hitters_create(size_t capacity);
+void heavy_hitters_free(heavy_hitters* hh);
+void heavy_hitters_add(heavy_hitters* hh, const char* key, size_t key_len, long weight);
+int heavy_hitters_merge(heavy_hitters* dst, const heavy_hitters* src);
+hh_entry* heavy_hitters_top(const heavy_hitters* hh, size_t k, size_t* out_count);
+long heavy_hitters_error_bound(const heavy_hitters* hh);
+
+#endif
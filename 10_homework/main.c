@@ -1,335 +1,482 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
+#include <limits.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <dirent.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "custom_map.h"
+#include "checkpoint.h"
+#include "tokenizer.h"
+#include "decompress.h"
+#include "heavy_hitters.h"
+#include "dimensions.h"
+#include "column_cache.h"
 
-typedef struct hash_entry {
-    char* key;
-    int value;
-    struct hash_entry* next;
-} hash_entry;
+#define FOLLOW_DEBOUNCE_MS 200
+#define MIN_CHUNK_SIZE (1L * 1024 * 1024)
+#define MAX_CHUNK_SIZE (64L * 1024 * 1024)
+#define CHUNKS_PER_THREAD 8
+#define BLOCKS_PER_THREAD 4
+#define DEFAULT_MEMORY_MB 256
 
 typedef struct {
-    hash_entry** buckets;
-    size_t capacity;
-    size_t size;
-    size_t load_factor_threshold;
-} custom_map;
-
-typedef struct {
-    char** filenames; 
-    size_t file_count;
+    const char* filename;
     long offset;
     long limit;
-    custom_map* urls;
-    custom_map* referes;
+    size_t order;
+} file_range;
+
+typedef struct {
+    file_range* chunks;
+    size_t count;
+    atomic_size_t next;
+} chunk_queue;
+
+typedef struct {
+    const char* cache_dir;
+    file_range* segments;
+    size_t count;
+    atomic_size_t next;
+    atomic_int written;
+} cache_queue;
+
+typedef struct {
+    custom_map* map;
+    heavy_hitters* summary;
+} aggregator;
+
+typedef struct {
+    long lines;
+    long rejected;
+    long bytes_read;
+    long map_probes;
+    long map_resizes;
+    long busy_ns;
+    long wait_ns;
+} thread_stats;
+
+typedef struct {
+    chunk_queue* queue;
+    cache_queue* cache;
+    decompress_pipeline* pipeline;
+    int use_mmap;
+    const dimension_spec* dims;
+    size_t dimension_count;
+    int tokenize_flags;
+    aggregator aggregators[MAX_DIMENSIONS];
     long total_bytes;
+    int failed;
+    thread_stats stats;
 } thread_arg;
 
 typedef struct {
-    long total_bytes;
-    char **top_urls;
-    char **top_referes;
-    size_t top_urls_size;
-    size_t top_referes_size;
-} file_statistics;
+    size_t threads;
+    long input_bytes;
+    long collect_ns;
+    long scan_ns;
+    long merge_ns;
+    long report_ns;
+    thread_stats totals;
+    thread_stats* per_thread;
+} run_stats;
+
+typedef struct {
+    const char* key;
+    size_t key_len;
+    long value;
+} map_entry;
 
-uint64_t fnv1a64(const char *s) {
-    uint64_t hash = 0xcbf29ce484222325ULL;
-    while (*s) {
-        hash ^= (unsigned char)(*s++);
-        hash *= 0x100000001b3ULL;
+typedef struct {
+    field_scratch scratch[MAX_DIMENSIONS];
+    int in_place;
+} line_parser;
+
+static int ranks_before(const map_entry* a, const map_entry* b) {
+    if (a->value != b->value) {
+        return a->value > b->value;
+    }
+    size_t min_len = a->key_len < b->key_len ? a->key_len : b->key_len;
+    int cmp = memcmp(a->key, b->key, min_len);
+    if (cmp != 0) {
+        return cmp < 0;
     }
-    return hash;
+    return a->key_len < b->key_len;
 }
 
-char** get_top_values_from_map(custom_map* map, size_t value) {
-    char** top_values = malloc(sizeof(char*) * value);
-    
-    char** used_keys = malloc(sizeof(char*) * value);
-    size_t used_count = 0;
+static int compare_entries(const void* a, const void* b) {
+    const map_entry* left = a;
+    const map_entry* right = b;
+    if (ranks_before(left, right)) return -1;
+    if (ranks_before(right, left)) return 1;
+    return 0;
+}
+
+static void sift_down(map_entry* heap, size_t size, size_t index) {
+    for (;;) {
+        size_t worst = index;
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+        if (left < size && ranks_before(&heap[worst], &heap[left])) worst = left;
+        if (right < size && ranks_before(&heap[worst], &heap[right])) worst = right;
+        if (worst == index) return;
+        map_entry tmp = heap[index];
+        heap[index] = heap[worst];
+        heap[worst] = tmp;
+        index = worst;
+    }
+}
+
+static void sift_up(map_entry* heap, size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!ranks_before(&heap[parent], &heap[index])) return;
+        map_entry tmp = heap[index];
+        heap[index] = heap[parent];
+        heap[parent] = tmp;
+        index = parent;
+    }
+}
+
+map_entry* get_top_values_from_map(custom_map* map, size_t value, size_t* out_count) {
+    if (value > map->size) {
+        value = map->size;
+    }
+    map_entry* heap = malloc(sizeof(map_entry) * (value > 0 ? value : 1));
+    size_t size = 0;
+    *out_count = 0;
+    if (heap == NULL) {
+        return NULL;
+    }
     
-    for (size_t i = 0; i < value; i++){
-        int current_max_value = 0;
-        char* best_key = NULL;
-        
-        for (size_t j = 0; j < map->capacity; j++){
-            hash_entry* entry = map->buckets[j];
-            while (entry) {
-                int already_used = 0;
-                for (size_t k = 0; k < used_count; k++) {
-                    if (strcmp(entry->key, used_keys[k]) == 0) {
-                        already_used = 1;
-                        break;
-                    }
-                }
-                
-                if (!already_used && entry->value > current_max_value) {
-                    current_max_value = entry->value;
-                    best_key = entry->key;
-                }
-                entry = entry->next;
-            }
+    for (size_t j = 0; j < map->capacity && value > 0; j++){
+        map_slot* slot = &map->slots[j];
+        if (slot->distance == 0) {
+            continue;
         }
-        
-        if (best_key) {
-            top_values[i] = strdup(best_key);
-            used_keys[used_count++] = best_key;
-        } else {
-            top_values[i] = strdup("(none)");
+        map_entry entry = { slot->key, slot->key_len, slot->value };
+        if (size < value) {
+            heap[size] = entry;
+            sift_up(heap, size++);
+        } else if (ranks_before(&entry, &heap[0])) {
+            heap[0] = entry;
+            sift_down(heap, size, 0);
         }
     }
     
-    free(used_keys);
-    return top_values;
+    qsort(heap, size, sizeof(map_entry), compare_entries);
+    *out_count = size;
+    return heap;
 }
 
-custom_map* create_map(void) {
-    size_t capacity = 1024;
-    custom_map* map = malloc(sizeof(custom_map));
-    map->buckets = calloc(capacity, sizeof(hash_entry*));
-    map->capacity = capacity;
-    map->size = 0;
-    map->load_factor_threshold = capacity * 3 / 4;
-    return map;
+typedef struct {
+    custom_map* dst;
+    custom_map* src;
+    int status;
+} merge_arg;
+
+static void* merge_func(void* arg) {
+    merge_arg* pair = (merge_arg*)arg;
+    pair->status = custom_map_merge(pair->dst, pair->src);
+    custom_map_free(pair->src);
+    return NULL;
 }
 
-static void free_bucket_chain(hash_entry* entry) {
-    while (entry) {
-        hash_entry* next = entry->next;
-        free(entry->key);
-        free(entry);
-        entry = next;
+custom_map* join_custom_maps(custom_map** maps, size_t count) {
+    if (count == 0) {
+        return create_map();
+    }
+    pthread_t* workers = malloc(sizeof(pthread_t) * count);
+    merge_arg* pairs = malloc(sizeof(merge_arg) * count);
+    int status = 0;
+    if (workers == NULL || pairs == NULL) {
+        free(workers);
+        free(pairs);
+        for (size_t i = 1; i < count; i++) {
+            status |= custom_map_merge(maps[0], maps[i]);
+            custom_map_free(maps[i]);
+        }
+        if (status != 0) {
+            custom_map_free(maps[0]);
+            return NULL;
+        }
+        return maps[0];
+    }
+    for (size_t stride = 1; stride < count; stride *= 2) {
+        size_t pair_count = 0;
+        for (size_t i = 0; i + stride < count; i += stride * 2) {
+            pairs[pair_count].dst = maps[i];
+            pairs[pair_count].src = maps[i + stride];
+            if (pthread_create(&workers[pair_count], NULL, merge_func, &pairs[pair_count]) != 0) {
+                merge_func(&pairs[pair_count]);
+                status |= pairs[pair_count].status;
+                continue;
+            }
+            pair_count++;
+        }
+        for (size_t p = 0; p < pair_count; p++) {
+            pthread_join(workers[p], NULL);
+            status |= pairs[p].status;
+        }
+    }
+    free(workers);
+    free(pairs);
+    if (status != 0) {
+        custom_map_free(maps[0]);
+        return NULL;
     }
+    return maps[0];
 }
 
-void custom_map_free(custom_map* map) {
-    for (size_t i = 0; i < map->capacity; i++) {
-        free_bucket_chain(map->buckets[i]);
+static int aggregator_add(aggregator* agg, const char* key, size_t key_len, long value) {
+    if (agg->summary) {
+        heavy_hitters_add(agg->summary, key, key_len, value);
+        return 0;
+    }
+    if (agg->map == NULL) {
+        return -1;
     }
-    free(map->buckets);
-    free(map);
+    return custom_map_add_or_insert(agg->map, key, key_len, value);
 }
 
-static size_t hash_index(const char* key, size_t capacity) {
-    uint64_t hash = fnv1a64(key);
-    return hash & (capacity - 1);
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
 }
 
-static void resize_map(custom_map* map) {
-    size_t old_capacity = map->capacity;
-    hash_entry** old_buckets = map->buckets;
-    
-    map->capacity *= 2;
-    map->load_factor_threshold = map->capacity * 3 / 4;
-    map->buckets = calloc(map->capacity, sizeof(hash_entry*));
-    map->size = 0;
-    
-    for (size_t i = 0; i < old_capacity; i++) {
-        hash_entry* entry = old_buckets[i];
-        while (entry) {
-            hash_entry* next = entry->next;
-            size_t new_index = hash_index(entry->key, map->capacity);
-            entry->next = map->buckets[new_index];
-            map->buckets[new_index] = entry;
-            map->size++;
-            entry = next;
+static void process_line(thread_arg* args, line_parser* parser, const char* line, size_t len) {
+    log_fields fields;
+    args->stats.lines++;
+    if (tokenize_line(line, len, args->tokenize_flags, &fields) != 0) {
+        args->stats.rejected++;
+        return;
+    }
+    args->total_bytes += fields.bytes;
+    for (size_t i = 0; i < args->dimension_count; i++) {
+        const dimension_spec* spec = &args->dims[i];
+        field_scratch* scratch = &parser->scratch[i];
+        scratch->in_place = parser->in_place;
+        const char* key;
+        size_t key_len;
+        if (spec->dim->extract(&fields, scratch, &key, &key_len) == 0 &&
+            aggregator_add(&args->aggregators[i], key, key_len, metric_value(spec->metric, &fields)) != 0) {
+            args->failed = 1;
         }
     }
-    
-    free(old_buckets);
 }
 
-void custom_map_set(custom_map* map, char* key, int value) {
-    size_t index = hash_index(key, map->capacity);
-    hash_entry* entry = map->buckets[index];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            entry->value = value;
-            return;
-        }
-        entry = entry->next;
+static int skip_partial_line(FILE* file, long offset) {
+    if (offset == 0) {
+        return 0;
     }
-    
-    hash_entry* new_entry = malloc(sizeof(hash_entry));
-    new_entry->key = strdup(key);
-    new_entry->value = value;
-    new_entry->next = map->buckets[index];
-    map->buckets[index] = new_entry;
-    map->size++;
-    
-    if (map->size > map->load_factor_threshold) {
-        resize_map(map);
+    if (fseek(file, offset - 1, SEEK_SET) != 0) {
+        return -1;
     }
-}
-
-int custom_map_get(custom_map* map, char* key) {
-    size_t index = hash_index(key, map->capacity);
-    hash_entry* entry = map->buckets[index];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            return entry->value;
-        }
-        entry = entry->next;
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n') {
     }
-    return 0;
+    return c == EOF ? -1 : 0;
 }
 
-custom_map* join_custom_maps(custom_map** maps, size_t count) {
-    custom_map* result = create_map();
-    for (size_t i = 0; i < count; i++){
-        for (size_t j = 0; j < maps[i]->capacity; j++){
-            hash_entry* entry = maps[i]->buckets[j];
-            while (entry) {
-                custom_map_set(
-                    result,
-                    entry->key,
-                    entry->value + custom_map_get(result, entry->key)
-                );
-                entry = entry->next;
-            }
-        }
+static void scan_stream(thread_arg* args, line_parser* parser, const char* filename, long position, long limit) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        perror("fopen");
+        return;
+    }
+    if (skip_partial_line(file, position) != 0) {
+        fclose(file);
+        return;
     }
-    return result;
+    position = ftell(file);
+    char* line = NULL;
+    size_t line_len = 0;
+    ssize_t read;
+    long start = position;
+    while (position < limit && (read = getline(&line, &line_len, file)) != -1) {
+        position += read;
+        process_line(args, parser, line, (size_t)read);
+    }
+    args->stats.bytes_read += position - start;
+    free(line);
+    fclose(file);
 }
 
-char* url_decode(const char* encoded) {
-    if (!encoded) return NULL;
-    
-    size_t len = strlen(encoded);
-    char* decoded = malloc(len + 1);
-    if (!decoded) return NULL;
+static void scan_mapped(thread_arg* args, line_parser* parser, const char* filename, long position, long limit) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return;
+    }
+    long page_size = sysconf(_SC_PAGESIZE);
+    long map_start = position > 0 ? (position - 1) / page_size * page_size : 0;
+    size_t size = (size_t)(st.st_size - map_start);
+    char* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, map_start);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        return;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
     
-    size_t i = 0, j = 0;
-    while (i < len) {
-        if (encoded[i] == '%' && i + 2 < len) {
-            int hex_value;
-            if (sscanf(&encoded[i + 1], "%2x", &hex_value) == 1) {
-                decoded[j++] = (char)hex_value;
-                i += 3;
-            } else {
-                decoded[j++] = encoded[i++];
-            }
-        } else if (encoded[i] == '+') {
-            decoded[j++] = ' ';
-            i++;
-        } else {
-            decoded[j++] = encoded[i++];
-        }
+    const char* data = mapping - map_start;
+    const char* end = data + st.st_size;
+    const char* cursor = data + position;
+    if (position > 0) {
+        const char* newline = memchr(cursor - 1, '\n', end - cursor + 1);
+        cursor = newline ? newline + 1 : end;
     }
-    decoded[j] = '\0';
-    return decoded;
+    const char* stop = (limit < st.st_size) ? data + limit : end;
+    const char* start = cursor;
+    while (cursor < stop) {
+        const char* newline = memchr(cursor, '\n', end - cursor);
+        const char* line_end = newline ? newline : end;
+        process_line(args, parser, cursor, line_end - cursor);
+        cursor = newline ? newline + 1 : end;
+    }
+    args->stats.bytes_read += cursor - start;
+    munmap(mapping, size);
 }
 
-char* get_url(const char *line) {
-    char *start = strstr(line, "\"");
-    if (!start) return NULL;
-    start++;
-    
-    char *space1 = strchr(start, ' ');
-    if (!space1) return NULL;
-    space1++;
-    
-    char *space2 = strchr(space1, ' ');
-    if (!space2) return NULL;
-    
-    size_t len = space2 - space1;
-    char *encoded_url = malloc(len + 1);
-    if (!encoded_url) return NULL;
-    
-    strncpy(encoded_url, space1, len);
-    encoded_url[len] = '\0';
-    
-    char *decoded_url = url_decode(encoded_url);
-    free(encoded_url);
-    
-    return decoded_url;
+static void scan_block(thread_arg* args, line_parser* parser, data_block* block) {
+    char* cursor = block->data;
+    char* end = block->data + block->len;
+    parser->in_place = 1;
+    args->stats.bytes_read += (long)block->len;
+    while (cursor < end) {
+        char* newline = memchr(cursor, '\n', end - cursor);
+        char* line_end = newline ? newline : end;
+        process_line(args, parser, cursor, line_end - cursor);
+        cursor = newline ? newline + 1 : end;
+    }
+    pipeline_release(args->pipeline, block);
 }
 
-long get_bytes(const char *line) {
-    char *quote_end = strstr(line, "\" ");
-    if (!quote_end) return -1;
-    quote_end += 2;
-    
-    char *space = strchr(quote_end, ' ');
-    if (!space) return -1;
-    space++;
-    
-    if (*space == '-') return 0;
-    return strtol(space, NULL, 10);
+static void aggregate_cache(thread_arg* args, const column_cache* cache) {
+    for (size_t d = 0; d < args->dimension_count && !args->failed; d++) {
+        cache_column column = args->dims[d].dim->column;
+        long* totals = column_cache_totals(cache, column, args->dims[d].metric);
+        if (totals == NULL) {
+            args->failed = 1;
+            break;
+        }
+        const cache_dictionary* dictionary = &cache->dictionaries[column];
+        for (uint64_t i = 0; i < dictionary->count && !args->failed; i++) {
+            const char* key = dictionary->strings + dictionary->offsets[i];
+            size_t key_len = dictionary->offsets[i + 1] - dictionary->offsets[i] - 1;
+            args->failed = aggregator_add(&args->aggregators[d], key, key_len, totals[i]) != 0;
+        }
+        free(totals);
+    }
+    args->total_bytes += column_cache_total_bytes(cache);
+    args->stats.lines += (long)cache->line_count;
+    args->stats.bytes_read += (long)cache->mapping_size;
 }
 
-char* get_referer(const char *line) {
-    char *quote_end = strstr(line, "\" ");
-    if (!quote_end) return NULL;
-    quote_end += 2;
-    
-    char *space = strchr(quote_end, ' ');
-    if (!space) return NULL;
-    space++;
-    
-    space = strchr(space, ' ');
-    if (!space) return NULL;
-    space++;
-    
-    if (*space != '"') return NULL;
-    space++;
-    
-    char *ref_end = strchr(space, '"');
-    if (!ref_end) return NULL;
-    
-    size_t len = ref_end - space;
-    char *referer = malloc(len + 1);
-    if (!referer) return NULL;
-    
-    strncpy(referer, space, len);
-    referer[len] = '\0';
-    
-    if (strcmp(referer, "-") == 0) {
-        free(referer);
-        return strdup("(no referer)");
+static void scan_cached(thread_arg* args, line_parser* parser, const file_range* segment) {
+    const char* cache_dir = args->cache->cache_dir;
+    const char* filename = segment->filename;
+    column_cache cache;
+    int opened = column_cache_open(cache_dir, filename, segment->offset, segment->limit, &cache) == 0;
+    if (!opened) {
+        atomic_store(&args->cache->written, 1);
     }
-    
-    char *decoded_referer = url_decode(referer);
-    free(referer);
-    
-    return decoded_referer;
+    if (opened || column_cache_build(cache_dir, filename, segment->offset, segment->limit, &cache) == 0) {
+        aggregate_cache(args, &cache);
+        column_cache_close(&cache);
+        return;
+    }
+    fprintf(stderr, "Column cache unavailable for %s at %ld, scanning text\n", filename, segment->offset);
+    parser->in_place = 0;
+    scan_mapped(args, parser, filename, segment->offset, segment->limit);
 }
 
 void* thread_func(void* arg) {
-    long total_bytes = 0;
     thread_arg* args = (thread_arg*)arg;
+    line_parser parser = {0};
+    args->total_bytes = 0;
+    args->failed = 0;
+    for (size_t i = 0; i < args->dimension_count; i++) {
+        if (args->aggregators[i].map == NULL && args->aggregators[i].summary == NULL) {
+            args->failed = 1;
+        }
+    }
+    memset(&args->stats, 0, sizeof(args->stats));
+    long started = now_ns();
     
-    for (size_t f = 0; f < args->file_count; f++) {
-        FILE* file = fopen(args->filenames[f], "r");
-        if (file == NULL) {
-            perror("fopen");
+    for (;;) {
+        size_t index = atomic_fetch_add(&args->cache->next, 1);
+        if (index >= args->cache->count) {
+            break;
+        }
+        scan_cached(args, &parser, &args->cache->segments[index]);
+    }
+    for (;;) {
+        data_block* block = pipeline_try_next(args->pipeline);
+        if (block) {
+            scan_block(args, &parser, block);
             continue;
         }
-        fseek(file, args->offset, SEEK_SET);
-        char* line = NULL;
-        size_t line_len = 0;
-        ssize_t read;
-        while ((read = getline(&line, &line_len, file)) != -1) {
-            char* url = get_url(line);
-            char* refer = get_referer(line);
-            if (url == NULL || refer == NULL) continue;
-            long bytes = get_bytes(line);
-            if (bytes == -1) continue;
-            total_bytes += bytes;
-            custom_map_set(args->urls, url, custom_map_get(args->urls, url) + bytes);
-            custom_map_set(args->referes, refer, custom_map_get(args->referes, refer) + bytes);
+        size_t index = atomic_fetch_add(&args->queue->next, 1);
+        if (index < args->queue->count) {
+            file_range* range = &args->queue->chunks[index];
+            parser.in_place = !args->use_mmap;
+            if (args->use_mmap) {
+                scan_mapped(args, &parser, range->filename, range->offset, range->limit);
+            } else {
+                scan_stream(args, &parser, range->filename, range->offset, range->limit);
+            }
+            continue;
         }
-        fclose(file);
+        long wait_start = now_ns();
+        block = pipeline_next(args->pipeline);
+        args->stats.wait_ns += now_ns() - wait_start;
+        if (block == NULL) {
+            break;
+        }
+        scan_block(args, &parser, block);
     }
-    args->total_bytes = total_bytes;
+    for (size_t i = 0; i < args->dimension_count; i++) {
+        free_scratch(&parser.scratch[i]);
+        if (args->aggregators[i].map) {
+            args->stats.map_probes += (long)args->aggregators[i].map->probes;
+            args->stats.map_resizes += (long)args->aggregators[i].map->resizes;
+        }
+    }
+    args->stats.busy_ns = now_ns() - started - args->stats.wait_ns;
     return NULL;
 }
 
+char* join_path(const char* dir, const char* name) {
+    size_t dir_len = strlen(dir);
+    int needs_slash = (dir_len > 0 && dir[dir_len - 1] != '/');
+    size_t full_path_len = dir_len + strlen(name) + (needs_slash ? 2 : 1);
+    char* full_path = malloc(full_path_len);
+    if (full_path == NULL) {
+        return NULL;
+    }
+    snprintf(full_path, full_path_len, needs_slash ? "%s/%s" : "%s%s", dir, name);
+    return full_path;
+}
+
 char** pathes_to_files(const char* logs_dir, size_t* out_count) {
     DIR *dir = opendir(logs_dir);
     if (dir == NULL){
@@ -338,11 +485,16 @@ char** pathes_to_files(const char* logs_dir, size_t* out_count) {
     }
 
     struct dirent *entry;
-    char** pathes = malloc(sizeof(char*) * 100);
+    size_t capacity = 100;
+    char** pathes = malloc(sizeof(char*) * capacity);
     size_t i = 0;
     while ((entry = readdir(dir)) != NULL){
         if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
             continue;
+        if (i == capacity) {
+            capacity *= 2;
+            pathes = realloc(pathes, sizeof(char*) * capacity);
+        }
         pathes[i++] = strdup(entry->d_name);
 
     }
@@ -351,106 +503,709 @@ char** pathes_to_files(const char* logs_dir, size_t* out_count) {
     return pathes;
 }
 
-int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <threads> <logs_dir>\n", argv[0]);
-        return 1;
+typedef struct {
+    char* path;
+    long start;
+    long end;
+    log_compression compression;
+    file_checkpoint checkpoint;
+} log_file;
+
+typedef enum {
+    STATS_NONE,
+    STATS_TEXT,
+    STATS_JSON,
+} stats_format;
+
+typedef struct {
+    size_t num_threads;
+    const char* logs_dir;
+    const char* state_path;
+    long top_count;
+    int use_mmap;
+    int follow;
+    int approx;
+    int bench;
+    stats_format stats;
+    const char* cache_dir;
+    size_t summary_capacity;
+    dimension_spec dims[MAX_DIMENSIONS];
+    size_t dimension_count;
+} analyzer_config;
+
+static long find_last_newline(int fd, long start, long size) {
+    char buffer[64 * 1024];
+    long block_end = size;
+    while (block_end > start) {
+        long block_start = block_end - (long)sizeof(buffer);
+        if (block_start < start) {
+            block_start = start;
+        }
+        ssize_t got = pread(fd, buffer, block_end - block_start, block_start);
+        if (got != block_end - block_start) {
+            return start;
+        }
+        char* newline = memrchr(buffer, '\n', got);
+        if (newline) {
+            return block_start + (newline - buffer) + 1;
+        }
+        block_end = block_start;
+    }
+    return start;
+}
+
+static log_file* collect_log_files(const char* logs_dir, const analyzer_state* state, int incremental, size_t* out_count) {
+    size_t names_count = 0;
+    char** names = pathes_to_files(logs_dir, &names_count);
+    if (names == NULL) {
+        return NULL;
+    }
+    log_file* files = malloc(sizeof(log_file) * (names_count > 0 ? names_count : 1));
+    size_t count = 0;
+    for (size_t i = 0; i < names_count; i++) {
+        char* path = join_path(logs_dir, names[i]);
+        free(names[i]);
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            if (fd >= 0) close(fd);
+            free(path);
+            continue;
+        }
+        
+        log_compression compression = detect_compression(fd);
+        if (!compression_supported(compression)) {
+            fprintf(stderr, "Skipping %s: built without zstd support\n", path);
+            close(fd);
+            free(path);
+            continue;
+        }
+        
+        log_file* file = &files[count++];
+        file->path = path;
+        file->start = 0;
+        file->end = st.st_size;
+        file->compression = compression;
+        file->checkpoint.dev = st.st_dev;
+        file->checkpoint.ino = st.st_ino;
+        file->checkpoint.fingerprint_len = 0;
+        file->checkpoint.fingerprint = 0;
+        if (incremental) {
+            const file_checkpoint* previous = find_checkpoint(state, st.st_dev, st.st_ino);
+            uint32_t fingerprint_len;
+            uint64_t fingerprint;
+            int resumed = previous && previous->offset <= st.st_size &&
+                file_fingerprint(fd, previous->fingerprint_len, &fingerprint_len, &fingerprint) == 0 &&
+                fingerprint == previous->fingerprint;
+            if (compression != LOG_PLAIN) {
+                if (resumed || (previous == NULL && state->checkpoint_count > 0)) {
+                    file->start = st.st_size;
+                }
+            } else {
+                if (resumed) {
+                    file->start = previous->offset;
+                }
+                file->end = find_last_newline(fd, file->start, st.st_size);
+            }
+            file_fingerprint(fd, file->end, &file->checkpoint.fingerprint_len, &file->checkpoint.fingerprint);
+        }
+        file->checkpoint.offset = file->end;
+        close(fd);
+    }
+    free(names);
+    *out_count = count;
+    return files;
+}
+
+static void free_log_files(log_file* files, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(files[i].path);
+    }
+    free(files);
+}
+
+static int compare_chunks(const void* a, const void* b) {
+    const file_range* left = a;
+    const file_range* right = b;
+    long left_size = left->limit - left->offset;
+    long right_size = right->limit - right->offset;
+    if (left_size != right_size) {
+        return left_size < right_size ? 1 : -1;
+    }
+    if (left->order != right->order) {
+        return left->order < right->order ? -1 : 1;
+    }
+    return 0;
+}
+
+static int build_chunk_queue(chunk_queue* queue, const log_file* files, size_t files_count, size_t num_threads) {
+    long total_size = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        if (files[i].compression == LOG_PLAIN) {
+            total_size += files[i].end - files[i].start;
+        }
     }
-    char *endptr = NULL;
-    long threads = strtol(argv[1], &endptr, 10);
-    const char* logs_dir = argv[2];
+    long chunk_size = total_size / (long)(num_threads * CHUNKS_PER_THREAD);
+    if (chunk_size < MIN_CHUNK_SIZE) chunk_size = MIN_CHUNK_SIZE;
+    if (chunk_size > MAX_CHUNK_SIZE) chunk_size = MAX_CHUNK_SIZE;
+    
+    size_t count = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        if (files[i].compression != LOG_PLAIN) {
+            continue;
+        }
+        long length = files[i].end - files[i].start;
+        count += (size_t)((length + chunk_size - 1) / chunk_size);
+    }
+    queue->chunks = malloc(sizeof(file_range) * (count > 0 ? count : 1));
+    if (queue->chunks == NULL) {
+        return -1;
+    }
+    queue->count = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        if (files[i].compression != LOG_PLAIN) {
+            continue;
+        }
+        for (long offset = files[i].start; offset < files[i].end; offset += chunk_size) {
+            file_range* chunk = &queue->chunks[queue->count];
+            chunk->filename = files[i].path;
+            chunk->offset = offset;
+            chunk->limit = offset + chunk_size < files[i].end ? offset + chunk_size : files[i].end;
+            chunk->order = queue->count++;
+        }
+    }
+    qsort(queue->chunks, queue->count, sizeof(file_range), compare_chunks);
+    atomic_init(&queue->next, 0);
+    return 0;
+}
+
+static int build_cache_queue(cache_queue* cached, log_file* files, size_t files_count) {
+    size_t count = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        if (files[i].compression == LOG_PLAIN && files[i].start < files[i].end) {
+            count += (size_t)((files[i].end + COLUMN_CACHE_SEGMENT_SIZE - 1) / COLUMN_CACHE_SEGMENT_SIZE);
+        }
+    }
+    cached->segments = malloc(sizeof(file_range) * (count > 0 ? count : 1));
+    if (cached->segments == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < files_count; i++) {
+        if (files[i].compression != LOG_PLAIN || files[i].start >= files[i].end) {
+            continue;
+        }
+        for (long offset = 0; offset < files[i].end; offset += COLUMN_CACHE_SEGMENT_SIZE) {
+            file_range* segment = &cached->segments[cached->count];
+            segment->filename = files[i].path;
+            segment->offset = offset;
+            segment->limit = offset + COLUMN_CACHE_SEGMENT_SIZE < files[i].end ? offset + COLUMN_CACHE_SEGMENT_SIZE : files[i].end;
+            segment->order = cached->count++;
+        }
+        files[i].start = files[i].end;
+    }
+    return 0;
+}
+
+static void prune_cache(const char* cache_dir, const log_file* files, size_t files_count) {
+    cache_source* live = malloc(sizeof(cache_source) * (files_count > 0 ? files_count : 1));
+    if (live == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < files_count; i++) {
+        live[i].dev = files[i].checkpoint.dev;
+        live[i].ino = files[i].checkpoint.ino;
+        live[i].size = (uint64_t)files[i].end;
+    }
+    column_cache_prune(cache_dir, live, files_count);
+    free(live);
+}
+
+static int absorb_map(custom_map** target, custom_map* source) {
+    if (source == NULL) {
+        return -1;
+    }
+    if ((*target)->size == 0) {
+        custom_map_free(*target);
+        *target = source;
+        return 0;
+    }
+    int status = custom_map_merge(*target, source);
+    custom_map_free(source);
+    return status;
+}
+
+static void absorb_summary(heavy_hitters** target, heavy_hitters* source) {
+    if (*target == NULL) {
+        *target = source;
+        return;
+    }
+    heavy_hitters_merge(*target, source);
+    heavy_hitters_free(source);
+}
+
+static int run_pass(const analyzer_config* config, analyzer_state* state, run_stats* stats) {
+    int incremental = config->state_path != NULL || config->follow;
+    memset(stats, 0, sizeof(*stats));
+    long collect_start = now_ns();
     size_t files_count = 0;
-    char** pathes = pathes_to_files(logs_dir, &files_count);
-    if (pathes == NULL){
-        fprintf(stderr, "Error");
-        return 1;
+    log_file* files = collect_log_files(config->logs_dir, state, incremental, &files_count);
+    if (files == NULL) {
+        return -1;
     }
-    if (*endptr != '\0' || threads <= 0) {
-        fprintf(stderr, "Invalid threads value: %s\n", argv[1]);
-        return 1;
+    stats->collect_ns = now_ns() - collect_start;
+    for (size_t i = 0; i < files_count; i++) {
+        stats->input_bytes += files[i].end - files[i].start;
+    }
+    
+    cache_queue cached = { config->cache_dir, NULL, 0, 0, 0 };
+    if (config->cache_dir && build_cache_queue(&cached, files, files_count) != 0) {
+        free_log_files(files, files_count);
+        return -1;
     }
+    atomic_init(&cached.next, 0);
+    atomic_init(&cached.written, 0);
     
-    size_t num_threads = (size_t)threads;
-    if (num_threads > files_count) {
-        num_threads = files_count;
+    chunk_queue queue;
+    if (build_chunk_queue(&queue, files, files_count, config->num_threads) != 0) {
+        free(cached.segments);
+        free_log_files(files, files_count);
+        return -1;
+    }
+    const char** compressed = malloc(sizeof(char*) * (files_count > 0 ? files_count : 1));
+    size_t compressed_count = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        if (files[i].compression != LOG_PLAIN && files[i].start < files[i].end) {
+            compressed[compressed_count++] = files[i].path;
+        }
+    }
+    size_t num_threads = config->num_threads;
+    size_t work_items = queue.count + cached.count;
+    if (compressed_count == 0 && num_threads > work_items) {
+        num_threads = work_items > 0 ? work_items : 1;
+    }
+    decompress_pipeline pipeline;
+    if (pipeline_start(&pipeline, compressed, compressed_count, num_threads, num_threads * BLOCKS_PER_THREAD) != 0) {
+        free(compressed);
+        free(cached.segments);
+        free(queue.chunks);
+        free_log_files(files, files_count);
+        return -1;
     }
     
+    stats->threads = num_threads;
+    long scan_start = now_ns();
     pthread_t* threads_arr = malloc(sizeof(pthread_t) * num_threads);
     thread_arg** args = malloc(sizeof(thread_arg*) * num_threads);
-    
-    size_t dir_len = strlen(logs_dir);
-    int needs_slash = (logs_dir[dir_len - 1] != '/');
-    size_t files_per_thread = files_count / num_threads;
-    size_t extra_files = files_count % num_threads;
-    size_t current_file_index = 0;
-
     for (size_t i = 0; i < num_threads; i++) {
         args[i] = malloc(sizeof(thread_arg));
-        size_t files_for_this_thread = files_per_thread + (i < extra_files ? 1 : 0);
-        args[i]->filenames = malloc(sizeof(char*) * files_for_this_thread);
-        args[i]->file_count = files_for_this_thread;
-        
-        for (size_t f = 0; f < files_for_this_thread; f++) {
-            size_t file_index = current_file_index + f;
-            size_t full_path_len = dir_len + strlen(pathes[file_index]) + (needs_slash ? 2 : 1);
-            args[i]->filenames[f] = malloc(full_path_len);
-            if (needs_slash) {
-                snprintf(args[i]->filenames[f], full_path_len, "%s/%s", logs_dir, pathes[file_index]);
+        args[i]->queue = &queue;
+        args[i]->cache = &cached;
+        args[i]->pipeline = &pipeline;
+        args[i]->use_mmap = config->use_mmap;
+        args[i]->dims = config->dims;
+        args[i]->dimension_count = config->dimension_count;
+        args[i]->tokenize_flags = dimensions_tokenize_flags(config->dims, config->dimension_count);
+        for (size_t d = 0; d < config->dimension_count; d++) {
+            if (config->approx) {
+                args[i]->aggregators[d] = (aggregator){ NULL, heavy_hitters_create(config->summary_capacity) };
             } else {
-                snprintf(args[i]->filenames[f], full_path_len, "%s%s", logs_dir, pathes[file_index]);
+                args[i]->aggregators[d] = (aggregator){ create_map(), NULL };
             }
         }
-        current_file_index += files_for_this_thread;
-        
-        args[i]->offset = 0;
-        args[i]->limit = 0;
-        args[i]->urls = create_map();
-        args[i]->referes = create_map();
         pthread_create(&threads_arr[i], NULL, thread_func, args[i]);
     }
     
-    
     for (size_t i = 0; i < num_threads; i++){
         pthread_join(threads_arr[i], NULL);
     }
+    int failed = pipeline_finish(&pipeline) != 0;
+    free(compressed);
+    long merge_start = now_ns();
+    stats->scan_ns = merge_start - scan_start;
     
-    custom_map** url_maps = malloc(sizeof(custom_map*) * num_threads);
-    custom_map** refer_maps = malloc(sizeof(custom_map*) * num_threads);
-    long total_bytes = 0;
+    custom_map** maps = malloc(sizeof(custom_map*) * num_threads);
+    stats->per_thread = malloc(sizeof(thread_stats) * num_threads);
     for (size_t i = 0; i < num_threads; i++){
-        url_maps[i] = args[i]->urls;
-        refer_maps[i] = args[i]->referes;
-        total_bytes += args[i]->total_bytes;
-    }
-    custom_map* urls = join_custom_maps(url_maps, num_threads);
-    custom_map* referes = join_custom_maps(refer_maps, num_threads);
-    printf("Total bytes: %ld\n", total_bytes);
-    char** top_urls = get_top_values_from_map(urls, 10);
-    char** top_referes = get_top_values_from_map(referes, 10);
-    for (size_t i = 0; i < 10; i++){
-        printf("Top URL: %s\n", top_urls[i]);
-        printf("Top Referer: %s\n", top_referes[i]);
+        const thread_stats* local = &args[i]->stats;
+        failed |= args[i]->failed;
+        state->total_bytes += args[i]->total_bytes;
+        stats->per_thread[i] = *local;
+        stats->totals.lines += local->lines;
+        stats->totals.rejected += local->rejected;
+        stats->totals.bytes_read += local->bytes_read;
+        stats->totals.map_probes += local->map_probes;
+        stats->totals.map_resizes += local->map_resizes;
+        stats->totals.busy_ns += local->busy_ns;
+        stats->totals.wait_ns += local->wait_ns;
     }
-    
-    free(top_urls);
-    free(top_referes);
-    custom_map_free(urls);
-    custom_map_free(referes);
-    for (size_t i = 0; i < num_threads; i++) {
-        for (size_t f = 0; f < args[i]->file_count; f++) {
-            free(args[i]->filenames[f]);
+    for (size_t d = 0; d < config->dimension_count && failed; d++) {
+        for (size_t i = 0; i < num_threads; i++){
+            if (args[i]->aggregators[d].map) custom_map_free(args[i]->aggregators[d].map);
+            heavy_hitters_free(args[i]->aggregators[d].summary);
+        }
+    }
+    for (size_t d = 0; d < config->dimension_count && !failed; d++) {
+        for (size_t i = 0; i < num_threads; i++){
+            maps[i] = args[i]->aggregators[d].map;
+            if (config->approx) {
+                absorb_summary(&state->summaries[d], args[i]->aggregators[d].summary);
+            }
         }
-        free(args[i]->filenames);
+        if (!config->approx) {
+            failed |= absorb_map(&state->maps[d], join_custom_maps(maps, num_threads)) != 0;
+        }
+    }
+    for (size_t i = 0; i < num_threads; i++){
         free(args[i]);
     }
+    stats->merge_ns = now_ns() - merge_start;
+    
+    if (config->cache_dir && atomic_load(&cached.written)) {
+        prune_cache(config->cache_dir, files, files_count);
+    }
+    free(state->checkpoints);
+    state->checkpoints = malloc(sizeof(file_checkpoint) * (files_count > 0 ? files_count : 1));
+    state->checkpoint_count = state->checkpoints ? files_count : 0;
+    for (size_t i = 0; i < state->checkpoint_count; i++) {
+        state->checkpoints[i] = files[i].checkpoint;
+    }
+    sort_checkpoints(state);
+    free_log_files(files, files_count);
+    free(cached.segments);
+    free(queue.chunks);
     free(args);
     free(threads_arr);
-    free(url_maps);
-    free(refer_maps);
-    for (size_t i = 0; i < files_count; i++) {
-        free(pathes[i]);
+    free(maps);
+    if (failed) {
+        fprintf(stderr, "Aggregation failed, totals are incomplete\n");
+        return -1;
     }
-    free(pathes);
-    
     return 0;
 }
+
+static int compare_keys(const void* a, const void* b) {
+    const map_entry* left = a;
+    const map_entry* right = b;
+    size_t min_len = left->key_len < right->key_len ? left->key_len : right->key_len;
+    int cmp = memcmp(left->key, right->key, min_len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (left->key_len > right->key_len) - (left->key_len < right->key_len);
+}
+
+static void print_series(const dimension_spec* spec, const custom_map* map) {
+    map_entry* entries = malloc(sizeof(map_entry) * (map->size > 0 ? map->size : 1));
+    size_t count = 0;
+    for (size_t j = 0; j < map->capacity; j++) {
+        const map_slot* slot = &map->slots[j];
+        if (slot->distance != 0) {
+            entries[count++] = (map_entry){ slot->key, slot->key_len, slot->value };
+        }
+    }
+    qsort(entries, count, sizeof(map_entry), compare_keys);
+    for (size_t i = 0; i < count; i++) {
+        printf("%s: %s (%ld %s)\n", spec->dim->label, entries[i].key, entries[i].value, metric_unit(spec->metric));
+    }
+    free(entries);
+}
+
+static void print_summary(const dimension_spec* spec, const heavy_hitters* summary, size_t top_count) {
+    const char* label = spec->dim->label;
+    const char* unit = metric_unit(spec->metric);
+    size_t top_size = 0;
+    hh_entry* top = heavy_hitters_top(summary, top_count, &top_size);
+    printf("%s error bound: %ld %s (%zu counters)\n", label, heavy_hitters_error_bound(summary), unit, summary->capacity);
+    for (size_t i = 0; i < top_count; i++) {
+        if (i < top_size) {
+            printf("Top %s: %s (~%ld %s, at least %ld)\n", label, top[i].key, top[i].count, unit, top[i].count - top[i].error);
+        } else {
+            printf("Top %s: (none)\n", label);
+        }
+    }
+    free(top);
+}
+
+static void print_top(const dimension_spec* spec, custom_map* map, size_t top_count) {
+    size_t top_size = 0;
+    map_entry* top = get_top_values_from_map(map, top_count, &top_size);
+    if (top == NULL) {
+        fprintf(stderr, "Out of memory while ranking %s\n", spec->dim->label);
+        return;
+    }
+    for (size_t i = 0; i < top_count; i++) {
+        if (i < top_size) {
+            printf("Top %s: %s (%ld %s)\n", spec->dim->label, top[i].key, top[i].value, metric_unit(spec->metric));
+        } else {
+            printf("Top %s: (none)\n", spec->dim->label);
+        }
+    }
+    free(top);
+}
+
+static void print_report(const analyzer_config* config, const analyzer_state* state) {
+    size_t top_count = (size_t)config->top_count;
+    printf("Total bytes: %ld\n", state->total_bytes);
+    for (size_t d = 0; d < config->dimension_count; d++) {
+        const dimension_spec* spec = &config->dims[d];
+        if (state->summaries[d]) {
+            print_summary(spec, state->summaries[d], top_count);
+        } else if (spec->dim->chronological) {
+            print_series(spec, state->maps[d]);
+        } else {
+            print_top(spec, state->maps[d], top_count);
+        }
+    }
+    fflush(stdout);
+}
+
+static void print_thread_text(const char* label, const thread_stats* stats) {
+    fprintf(stderr, "%s: %ld lines (%ld rejected), %ld bytes read, %ld map probes, %ld resizes, "
+        "busy %.3f ms, waiting %.3f ms\n",
+        label, stats->lines, stats->rejected, stats->bytes_read, stats->map_probes, stats->map_resizes,
+        stats->busy_ns / 1e6, stats->wait_ns / 1e6);
+}
+
+static void print_thread_json(const thread_stats* stats) {
+    fprintf(stderr, "{\"lines\":%ld,\"rejected\":%ld,\"bytes_read\":%ld,\"map_probes\":%ld,"
+        "\"map_resizes\":%ld,\"busy_ns\":%ld,\"wait_ns\":%ld}",
+        stats->lines, stats->rejected, stats->bytes_read, stats->map_probes, stats->map_resizes,
+        stats->busy_ns, stats->wait_ns);
+}
+
+static void print_stats(stats_format format, const run_stats* stats) {
+    if (format == STATS_JSON) {
+        fprintf(stderr, "{\"tokenizer\":\"%s\",\"threads\":%zu,\"input_bytes\":%ld,"
+            "\"phases_ns\":{\"collect\":%ld,\"scan\":%ld,\"merge\":%ld,\"report\":%ld},\"totals\":",
+            tokenizer_name(), stats->threads, stats->input_bytes,
+            stats->collect_ns, stats->scan_ns, stats->merge_ns, stats->report_ns);
+        print_thread_json(&stats->totals);
+        fprintf(stderr, ",\"per_thread\":[");
+        for (size_t i = 0; i < stats->threads; i++) {
+            if (i > 0) fputc(',', stderr);
+            print_thread_json(&stats->per_thread[i]);
+        }
+        fprintf(stderr, "]}\n");
+        return;
+    }
+    fprintf(stderr, "Stats: %zu threads, %ld input bytes, %s tokenizer\n", stats->threads, stats->input_bytes, tokenizer_name());
+    fprintf(stderr, "Phase collect: %.3f ms\n", stats->collect_ns / 1e6);
+    fprintf(stderr, "Phase scan: %.3f ms\n", stats->scan_ns / 1e6);
+    fprintf(stderr, "Phase merge: %.3f ms\n", stats->merge_ns / 1e6);
+    fprintf(stderr, "Phase report: %.3f ms\n", stats->report_ns / 1e6);
+    for (size_t i = 0; i < stats->threads; i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "Thread %zu", i);
+        print_thread_text(label, &stats->per_thread[i]);
+    }
+    print_thread_text("Total", &stats->totals);
+}
+
+static void report(const analyzer_config* config, const analyzer_state* state, run_stats* stats) {
+    long report_start = now_ns();
+    print_report(config, state);
+    stats->report_ns = now_ns() - report_start;
+    if (config->stats != STATS_NONE) {
+        print_stats(config->stats, stats);
+    }
+    if (!config->bench) {
+        return;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double wall = (stats->collect_ns + stats->scan_ns + stats->merge_ns + stats->report_ns) / 1e9;
+    double megabytes = stats->input_bytes / (1024.0 * 1024.0);
+    fprintf(stderr, "bench: threads=%zu input=%.1fMB lines=%ld wall=%.3fs %.1fMB/s %.0flines/s "
+        "scan=%.1fms merge=%.1fms topk=%.1fms peak_rss=%ldKB\n",
+        stats->threads, megabytes, stats->totals.lines, wall,
+        wall > 0 ? megabytes / wall : 0, wall > 0 ? stats->totals.lines / wall : 0,
+        stats->scan_ns / 1e6, stats->merge_ns / 1e6, stats->report_ns / 1e6, usage.ru_maxrss);
+}
+
+static volatile sig_atomic_t follow_stop = 0;
+
+static void request_follow_stop(int signum) {
+    (void)signum;
+    follow_stop = 1;
+}
+
+static void drain_events(int fd) {
+    char events[4096];
+    while (read(fd, events, sizeof(events)) > 0) {
+    }
+}
+
+static int follow_logs(const analyzer_config* config, analyzer_state* state) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        perror("inotify_init1");
+        return -1;
+    }
+    uint32_t mask = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+    if (inotify_add_watch(fd, config->logs_dir, mask) < 0) {
+        perror("inotify_add_watch");
+        close(fd);
+        return -1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_follow_stop;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    struct timespec debounce = { FOLLOW_DEBOUNCE_MS / 1000, (FOLLOW_DEBOUNCE_MS % 1000) * 1000000L };
+    int status = 0;
+    while (!follow_stop) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            status = -1;
+            break;
+        }
+        nanosleep(&debounce, NULL);
+        drain_events(fd);
+        run_stats stats;
+        if (run_pass(config, state, &stats) != 0) {
+            status = -1;
+            break;
+        }
+        report(config, state, &stats);
+        free(stats.per_thread);
+        if (config->state_path && save_state(state, config->state_path) != 0) {
+            status = -1;
+            break;
+        }
+    }
+    close(fd);
+    return status;
+}
+
+static int parse_positive(const char* text, long* out) {
+    char* endptr = NULL;
+    long value = strtol(text, &endptr, 10);
+    if (endptr == text || *endptr != '\0' || value <= 0) {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    analyzer_config config = {0};
+    config.top_count = 10;
+    long memory_mb = DEFAULT_MEMORY_MB;
+    const char* dims_text = DEFAULT_DIMENSIONS;
+    char* positional[2];
+    int positional_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mmap") == 0) {
+            config.use_mmap = 1;
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            config.follow = 1;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            config.bench = 1;
+        } else if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=text") == 0) {
+            config.stats = STATS_TEXT;
+        } else if (strcmp(argv[i], "--stats=json") == 0) {
+            config.stats = STATS_JSON;
+        } else if (strcmp(argv[i], "--state") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Missing --state file\n");
+                return 1;
+            }
+            config.state_path = argv[++i];
+        } else if (strcmp(argv[i], "--dims") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Missing --dims list\n");
+                return 1;
+            }
+            dims_text = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Missing --cache directory\n");
+                return 1;
+            }
+            config.cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--approx") == 0) {
+            config.approx = 1;
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            if (i + 1 >= argc || parse_positive(argv[++i], &memory_mb) != 0) {
+                fprintf(stderr, "Invalid --memory value\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--top") == 0) {
+            if (i + 1 >= argc || parse_positive(argv[++i], &config.top_count) != 0) {
+                fprintf(stderr, "Invalid --top value\n");
+                return 1;
+            }
+        } else if (positional_count < 2) {
+            positional[positional_count++] = argv[i];
+        } else {
+            positional_count++;
+        }
+    }
+    if (positional_count != 2) {
+        fprintf(stderr, "Usage: %s [--mmap] [--top N] [--dims LIST] [--cache DIR] [--state FILE] [--follow] [--approx [--memory MB]] [--bench] [--stats[=text|json]] <threads> <logs_dir>\n", argv[0]);
+        return 1;
+    }
+    long threads;
+    if (parse_positive(positional[0], &threads) != 0) {
+        fprintf(stderr, "Invalid threads value: %s\n", positional[0]);
+        return 1;
+    }
+    config.num_threads = (size_t)threads;
+    if (parse_dimensions(dims_text, config.dims, &config.dimension_count) != 0) {
+        return 1;
+    }
+    if (config.cache_dir) {
+        if (config.state_path || config.follow) {
+            fprintf(stderr, "--cache cannot be combined with --state or --follow\n");
+            return 1;
+        }
+        for (size_t i = 0; i < config.dimension_count; i++) {
+            if (config.dims[i].dim->column == CACHE_COLUMN_NONE) {
+                fprintf(stderr, "--cache only supports the url and referer dimensions\n");
+                return 1;
+            }
+        }
+    }
+    if (config.approx) {
+        if (config.state_path || config.follow) {
+            fprintf(stderr, "--approx cannot be combined with --state or --follow\n");
+            return 1;
+        }
+        size_t summaries = config.dimension_count * (config.num_threads + 1);
+        config.summary_capacity = heavy_hitters_capacity_for((size_t)memory_mb * 1024 * 1024 / summaries);
+        if (config.summary_capacity < (size_t)config.top_count) {
+            config.summary_capacity = (size_t)config.top_count;
+        }
+    }
+    config.logs_dir = positional[1];
+    tokenizer_init();
+    
+    analyzer_state* state = config.state_path ? load_state(config.state_path, config.dims, config.dimension_count) : create_state(config.dims, config.dimension_count);
+    if (state == NULL) {
+        return 1;
+    }
+    run_stats stats;
+    if (run_pass(&config, state, &stats) != 0) {
+        fprintf(stderr, "Error");
+        free_state(state);
+        return 1;
+    }
+    report(&config, state, &stats);
+    free(stats.per_thread);
+    if (config.state_path && save_state(state, config.state_path) != 0) {
+        free_state(state);
+        return 1;
+    }
+    int status = 0;
+    if (config.follow && follow_logs(&config, state) != 0) {
+        status = 1;
+    }
+    
+    free_state(state);
+    return status;
+}
@@ -0,0 +1,219 @@
+#include <string.h>
+#include "tokenizer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#endif
+
+enum {
+    URL_WAIT_QUOTE,
+    URL_WAIT_METHOD_END,
+    URL_WAIT_END,
+    URL_DONE,
+};
+
+enum {
+    TAIL_WAIT_REQUEST_END,
+    TAIL_WAIT_STATUS_END,
+    TAIL_WAIT_BYTES_END,
+    TAIL_WAIT_REFERER_END,
+    TAIL_WAIT_USER_AGENT_END,
+    TAIL_DONE,
+};
+
+typedef struct {
+    int flags;
+    int url_state;
+    int tail_state;
+    size_t url_start;
+    size_t tail_from;
+    size_t status_start;
+    size_t referer_start;
+    size_t user_agent_start;
+} scan_state;
+
+static inline void start_scan(scan_state* st, const char* line, size_t len, int flags, log_fields* fields) {
+    memset(st, 0, sizeof(*st));
+    st->flags = flags;
+    memset(fields, 0, sizeof(*fields));
+    fields->line = line;
+    fields->line_len = len;
+}
+
+static inline int feed_delimiter(scan_state* st, const char* line, size_t len, size_t pos, log_fields* fields) {
+    char c = line[pos];
+    switch (st->url_state) {
+    case URL_WAIT_QUOTE:
+        if (c == '"') {
+            st->url_state = URL_WAIT_METHOD_END;
+        } else if (fields->ip == NULL) {
+            fields->ip = line;
+            fields->ip_len = pos;
+        }
+        break;
+    case URL_WAIT_METHOD_END:
+        if (c == ' ') {
+            st->url_start = pos + 1;
+            st->url_state = URL_WAIT_END;
+        }
+        break;
+    case URL_WAIT_END:
+        if (c == ' ') {
+            fields->url = line + st->url_start;
+            fields->url_len = pos - st->url_start;
+            st->url_state = URL_DONE;
+        }
+        break;
+    }
+    
+    if (pos < st->tail_from) {
+        return 0;
+    }
+    switch (st->tail_state) {
+    case TAIL_WAIT_REQUEST_END:
+        if (c == '"' && pos + 1 < len && line[pos + 1] == ' ') {
+            st->tail_from = pos + 2;
+            st->status_start = pos + 2;
+            st->tail_state = TAIL_WAIT_STATUS_END;
+        }
+        break;
+    case TAIL_WAIT_STATUS_END:
+        if (c == ' ') {
+            fields->status = line + st->status_start;
+            fields->status_len = pos - st->status_start;
+            long bytes = 0;
+            for (size_t i = pos + 1; i < len && line[i] >= '0' && line[i] <= '9'; i++) {
+                bytes = bytes * 10 + (line[i] - '0');
+            }
+            fields->bytes = bytes;
+            st->tail_state = TAIL_WAIT_BYTES_END;
+        }
+        break;
+    case TAIL_WAIT_BYTES_END:
+        if (c == ' ') {
+            if (pos + 1 >= len || line[pos + 1] != '"') {
+                st->tail_state = TAIL_DONE;
+                return -1;
+            }
+            st->referer_start = pos + 2;
+            st->tail_from = pos + 2;
+            st->tail_state = TAIL_WAIT_REFERER_END;
+        }
+        break;
+    case TAIL_WAIT_REFERER_END:
+        if (c == '"') {
+            fields->referer = line + st->referer_start;
+            fields->referer_len = pos - st->referer_start;
+            st->tail_state = TAIL_DONE;
+            if ((st->flags & TOKENIZE_USER_AGENT) && pos + 2 < len && line[pos + 1] == ' ' && line[pos + 2] == '"') {
+                st->user_agent_start = pos + 3;
+                st->tail_from = pos + 3;
+                st->tail_state = TAIL_WAIT_USER_AGENT_END;
+            }
+        }
+        break;
+    case TAIL_WAIT_USER_AGENT_END:
+        if (c == '"') {
+            fields->user_agent = line + st->user_agent_start;
+            fields->user_agent_len = pos - st->user_agent_start;
+            st->tail_state = TAIL_DONE;
+        }
+        break;
+    }
+    return st->url_state == URL_DONE && st->tail_state == TAIL_DONE;
+}
+
+static int finish(const scan_state* st) {
+    int tail_done = st->tail_state == TAIL_DONE || st->tail_state == TAIL_WAIT_USER_AGENT_END;
+    return (st->url_state == URL_DONE && tail_done) ? 0 : -1;
+}
+
+static int tokenize_scalar(const char* line, size_t len, int flags, log_fields* fields) {
+    scan_state st;
+    start_scan(&st, line, len, flags, fields);
+    for (size_t i = 0; i < len; i++) {
+        if (line[i] == '"' || line[i] == ' ') {
+            int done = feed_delimiter(&st, line, len, i, fields);
+            if (done != 0) return done > 0 ? 0 : -1;
+        }
+    }
+    return finish(&st);
+}
+
+#ifdef TOKENIZER_X86
+static int tokenize_sse2(const char* line, size_t len, int flags, log_fields* fields) {
+    scan_state st;
+    start_scan(&st, line, len, flags, fields);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i space = _mm_set1_epi8(' ');
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(line + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, space)));
+        while (mask) {
+            int done = feed_delimiter(&st, line, len, i + __builtin_ctz(mask), fields);
+            if (done != 0) return done > 0 ? 0 : -1;
+            mask &= mask - 1;
+        }
+    }
+    for (; i < len; i++) {
+        if (line[i] == '"' || line[i] == ' ') {
+            int done = feed_delimiter(&st, line, len, i, fields);
+            if (done != 0) return done > 0 ? 0 : -1;
+        }
+    }
+    return finish(&st);
+}
+
+__attribute__((target("avx2")))
+static int tokenize_avx2(const char* line, size_t len, int flags, log_fields* fields) {
+    scan_state st;
+    start_scan(&st, line, len, flags, fields);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i space = _mm256_set1_epi8(' ');
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(line + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, space)));
+        while (mask) {
+            int done = feed_delimiter(&st, line, len, i + __builtin_ctz(mask), fields);
+            if (done != 0) return done > 0 ? 0 : -1;
+            mask &= mask - 1;
+        }
+    }
+    for (; i < len; i++) {
+        if (line[i] == '"' || line[i] == ' ') {
+            int done = feed_delimiter(&st, line, len, i, fields);
+            if (done != 0) return done > 0 ? 0 : -1;
+        }
+    }
+    return finish(&st);
+}
+#endif
+
+static int (*tokenize_impl)(const char*, size_t, int, log_fields*) = tokenize_scalar;
+static const char* tokenize_impl_name = "scalar";
+
+void tokenizer_init(void) {
+#ifdef TOKENIZER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        tokenize_impl = tokenize_avx2;
+        tokenize_impl_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        tokenize_impl = tokenize_sse2;
+        tokenize_impl_name = "sse2";
+    }
+#endif
+}
+
+const char* tokenizer_name(void) {
+    return tokenize_impl_name;
+}
+
+int tokenize_line(const char* line, size_t len, int flags, log_fields* fields) {
+    return tokenize_impl(line, len, flags, fields);
+}
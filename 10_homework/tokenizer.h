@@ -0,0 +1,28 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stddef.h>
+
+#define TOKENIZE_USER_AGENT 0x1
+
+typedef struct {
+    const char* line;
+    size_t line_len;
+    const char* ip;
+    size_t ip_len;
+    const char* url;
+    size_t url_len;
+    const char* status;
+    size_t status_len;
+    const char* referer;
+    size_t referer_len;
+    const char* user_agent;
+    size_t user_agent_len;
+    long bytes;
+} log_fields;
+
+void tokenizer_init(void);
+const char* tokenizer_name(void);
+int tokenize_line(const char* line, size_t len, int flags, log_fields* fields);
+
+#endif
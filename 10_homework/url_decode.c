@@ -0,0 +1,71 @@
+#include <string.h>
+#include "url_decode.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HEX_VALID 0x10
+
+static const unsigned char hex_table[256] = {
+    ['0'] = HEX_VALID | 0x0, ['1'] = HEX_VALID | 0x1, ['2'] = HEX_VALID | 0x2, ['3'] = HEX_VALID | 0x3,
+    ['4'] = HEX_VALID | 0x4, ['5'] = HEX_VALID | 0x5, ['6'] = HEX_VALID | 0x6, ['7'] = HEX_VALID | 0x7,
+    ['8'] = HEX_VALID | 0x8, ['9'] = HEX_VALID | 0x9,
+    ['a'] = HEX_VALID | 0xa, ['b'] = HEX_VALID | 0xb, ['c'] = HEX_VALID | 0xc,
+    ['d'] = HEX_VALID | 0xd, ['e'] = HEX_VALID | 0xe, ['f'] = HEX_VALID | 0xf,
+    ['A'] = HEX_VALID | 0xa, ['B'] = HEX_VALID | 0xb, ['C'] = HEX_VALID | 0xc,
+    ['D'] = HEX_VALID | 0xd, ['E'] = HEX_VALID | 0xe, ['F'] = HEX_VALID | 0xf,
+};
+
+int url_needs_decoding(const char* encoded, size_t len) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i percent = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(encoded + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, percent), _mm_cmpeq_epi8(block, plus));
+        if (_mm_movemask_epi8(hits) != 0) {
+            return 1;
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (encoded[i] == '%' || encoded[i] == '+') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size_t url_decode(const char* encoded, size_t len, char* decoded) {
+    size_t i = 0, j = 0;
+    while (i < len) {
+        char c = encoded[i];
+        if (c == '%' && i + 2 < len) {
+            unsigned char high = hex_table[(unsigned char)encoded[i + 1]];
+            unsigned char low = hex_table[(unsigned char)encoded[i + 2]];
+            if (high & low & HEX_VALID) {
+                decoded[j++] = (char)(((high & 0x0f) << 4) | (low & 0x0f));
+                i += 3;
+                continue;
+            }
+        }
+        decoded[j++] = (c == '+') ? ' ' : c;
+        i++;
+    }
+    return j;
+}
+
+size_t url_decode_in_place(char* text, size_t len) {
+    char* first = memchr(text, '%', len);
+    char* plus = memchr(text, '+', first ? (size_t)(first - text) : len);
+    if (plus) {
+        first = plus;
+    }
+    if (first == NULL) {
+        return len;
+    }
+    size_t skip = first - text;
+    return skip + url_decode(first, len - skip, first);
+}
@@ -0,0 +1,10 @@
+#ifndef URL_DECODE_H
+#define URL_DECODE_H
+
+#include <stddef.h>
+
+int url_needs_decoding(const char* encoded, size_t len);
+size_t url_decode(const char* encoded, size_t len, char* decoded);
+size_t url_decode_in_place(char* text, size_t len);
+
+#endif